@@ -6,12 +6,22 @@
 #include "brave/browser/brave_ads/ads_tab_helper.h"
 
 #include <memory>
+#include <string>
 #include <utility>
 
+#include "base/json/json_reader.h"
+#include "base/logging.h"
+#include "base/metrics/histogram_functions.h"
+#include "base/strings/pattern.h"
+#include "base/strings/strcat.h"
+#include "base/strings/stringprintf.h"
+#include "bat/ads/pref_names.h"
 #include "brave/browser/brave_ads/ads_service_factory.h"
+#include "brave/components/brave_ads/browser/features.h"
 #include "chrome/browser/profiles/profile.h"
 #include "components/dom_distiller/content/browser/distiller_javascript_utils.h"
 #include "components/dom_distiller/content/browser/distiller_page_web_contents.h"
+#include "components/prefs/pref_service.h"
 #include "components/sessions/content/session_tab_helper.h"
 #include "content/public/browser/navigation_handle.h"
 #include "content/public/browser/render_frame_host.h"
@@ -27,6 +37,24 @@
 
 namespace brave_ads {
 
+namespace {
+
+// Records the size and extraction time of page content separately for compact
+// and full extraction so that both modes can be compared
+void RecordPageContentMetrics(const std::string& name,
+                              const bool is_compact,
+                              const size_t size,
+                              const base::TimeDelta elapsed_time) {
+  const std::string histogram_name = base::StrCat(
+      {"Brave.Ads.PageContent.", name, is_compact ? ".Compact" : ".Full"});
+
+  base::UmaHistogramCounts10M(base::StrCat({histogram_name, ".Size"}), size);
+  base::UmaHistogramTimes(base::StrCat({histogram_name, ".ExtractionTime"}),
+                          elapsed_time);
+}
+
+}  // namespace
+
 AdsTabHelper::AdsTabHelper(content::WebContents* web_contents)
     : WebContentsObserver(web_contents),
       tab_id_(sessions::SessionTabHelper::IdForTab(web_contents)),
@@ -73,38 +101,113 @@ void AdsTabHelper::TabUpdated() {
                              is_browser_active_);
 }
 
+bool AdsTabHelper::ShouldExtractFullPageHtml() const {
+  Profile* profile =
+      Profile::FromBrowserContext(web_contents()->GetBrowserContext());
+  const std::string json =
+      profile->GetPrefs()->GetString(ads::prefs::kFullPageHtmlUrlPatterns);
+
+  const base::Optional<base::Value> url_patterns = base::JSONReader::Read(json);
+  if (!url_patterns || !url_patterns->is_list()) {
+    return false;
+  }
+
+  // Conversion URL patterns only use "*" wildcards, which have the same meaning
+  // for |base::MatchPattern|
+  for (const auto& url_pattern : url_patterns->GetList()) {
+    if (!url_pattern.is_string()) {
+      continue;
+    }
+
+    for (const auto& url : redirect_chain_) {
+      if (base::MatchPattern(url.spec(), url_pattern.GetString())) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
 void AdsTabHelper::RunIsolatedJavaScript(
     content::RenderFrameHost* render_frame_host) {
   DCHECK(render_frame_host);
 
+  const bool is_compact_page_content_enabled =
+      features::IsCompactPageContentEnabled();
+
+  const bool is_compact_html =
+      is_compact_page_content_enabled && !ShouldExtractFullPageHtml();
+
+  std::string html_script;
+  if (is_compact_html) {
+    // The default conversion id pattern only matches meta elements, so there is
+    // no need to serialize the entire document. Meta elements are separated by
+    // newlines so that greedy patterns cannot match across elements
+    html_script =
+        "Array.from(document.querySelectorAll('meta'))"
+        ".map(element => element.outerHTML).join('\\n')";
+  } else {
+    html_script = "new XMLSerializer().serializeToString(document)";
+  }
+
+  std::string text_script;
+  if (is_compact_page_content_enabled) {
+    text_script = base::StringPrintf(
+        "(document.body ? document.body.innerText : '')"
+        ".replace(/\\s+/g, ' ').substring(0, %d)",
+        features::CompactPageContentMaxTextLength());
+  } else {
+    text_script = "document.body.innerText";
+  }
+
+  const base::TimeTicks start_time = base::TimeTicks::Now();
+
   dom_distiller::RunIsolatedJavaScript(
-      render_frame_host, "new XMLSerializer().serializeToString(document)",
+      render_frame_host, html_script,
       base::BindOnce(&AdsTabHelper::OnJavaScriptHtmlResult,
-                     weak_factory_.GetWeakPtr()));
+                     weak_factory_.GetWeakPtr(), is_compact_html, start_time));
 
   dom_distiller::RunIsolatedJavaScript(
-      render_frame_host, "document.body.innerText",
+      render_frame_host, text_script,
       base::BindOnce(&AdsTabHelper::OnJavaScriptTextResult,
-                     weak_factory_.GetWeakPtr()));
+                     weak_factory_.GetWeakPtr(),
+                     is_compact_page_content_enabled, start_time));
 }
 
-void AdsTabHelper::OnJavaScriptHtmlResult(base::Value value) {
+void AdsTabHelper::OnJavaScriptHtmlResult(const bool is_compact,
+                                          const base::TimeTicks start_time,
+                                          base::Value value) {
   DCHECK(ads_service_ && ads_service_->IsEnabled());
 
   DCHECK(value.is_string());
   std::string html;
   value.GetAsString(&html);
 
+  const base::TimeDelta elapsed_time = base::TimeTicks::Now() - start_time;
+  RecordPageContentMetrics("Html", is_compact, html.size(), elapsed_time);
+
+  VLOG(1) << "Extracted " << html.size() << " bytes of HTML in "
+          << elapsed_time.InMilliseconds() << "ms";
+
   ads_service_->OnHtmlLoaded(tab_id_, redirect_chain_, html);
 }
 
-void AdsTabHelper::OnJavaScriptTextResult(base::Value value) {
+void AdsTabHelper::OnJavaScriptTextResult(const bool is_compact,
+                                          const base::TimeTicks start_time,
+                                          base::Value value) {
   DCHECK(ads_service_ && ads_service_->IsEnabled());
 
   DCHECK(value.is_string());
   std::string text;
   value.GetAsString(&text);
 
+  const base::TimeDelta elapsed_time = base::TimeTicks::Now() - start_time;
+  RecordPageContentMetrics("Text", is_compact, text.size(), elapsed_time);
+
+  VLOG(1) << "Extracted " << text.size() << " bytes of text in "
+          << elapsed_time.InMilliseconds() << "ms";
+
   ads_service_->OnTextLoaded(tab_id_, redirect_chain_, text);
 }
 
@@ -13,6 +13,7 @@
 
 #include "base/macros.h"
 #include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
 #include "build/build_config.h"
 #include "components/sessions/core/session_id.h"
 #include "content/public/browser/media_player_id.h"
@@ -59,11 +60,17 @@ class AdsTabHelper : public content::WebContentsObserver,
 
   void TabUpdated();
 
+  bool ShouldExtractFullPageHtml() const;
+
   void RunIsolatedJavaScript(content::RenderFrameHost* render_frame_host);
 
-  void OnJavaScriptHtmlResult(base::Value value);
+  void OnJavaScriptHtmlResult(const bool is_compact,
+                              const base::TimeTicks start_time,
+                              base::Value value);
 
-  void OnJavaScriptTextResult(base::Value value);
+  void OnJavaScriptTextResult(const bool is_compact,
+                              const base::TimeTicks start_time,
+                              base::Value value);
 
   // content::WebContentsObserver overrides
   void DidFinishNavigation(
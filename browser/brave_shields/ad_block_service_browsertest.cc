@@ -12,6 +12,7 @@
 #include "base/base64.h"
 #include "base/path_service.h"
 #include "base/task/post_task.h"
+#include "base/test/metrics/histogram_tester.h"
 #include "base/test/thread_test_helper.h"
 #include "brave/browser/brave_browser_process.h"
 #include "brave/browser/net/brave_ad_block_tp_network_delegate_helper.h"
@@ -354,6 +355,42 @@ IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, AdsGetBlockedByRegionalBlocker) {
   EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 1ULL);
 }
 
+// Block an ad using the regional blocker, then disable the list and make sure
+// the ad is no longer blocked, rather than served from cached match results.
+IN_PROC_BROWSER_TEST_F(AdBlockServiceTest,
+                       AdsNotBlockedAfterRegionalBlockerIsDisabled) {
+  g_browser_process->SetApplicationLocale("fr");
+  ASSERT_STREQ(g_browser_process->GetApplicationLocale().c_str(), "fr");
+
+  ASSERT_TRUE(InstallRegionalAdBlockExtension(kAdBlockEasyListFranceUUID));
+  ASSERT_TRUE(StartAdBlockRegionalServices());
+
+  GURL url = embedded_test_server()->GetURL(kAdBlockTestPage);
+  ui_test_utils::NavigateToURL(browser(), url);
+  content::WebContents* contents =
+      browser()->tab_strip_model()->GetActiveWebContents();
+
+  ASSERT_EQ(true, EvalJs(contents,
+                         "setExpectations(0, 1, 0, 0);"
+                         "addImage('ad_fr.png')"));
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 1ULL);
+
+  const uint64_t engine_generation =
+      brave_shields::AdBlockBaseService::GetEngineGeneration();
+  g_brave_browser_process->ad_block_regional_service_manager()
+      ->EnableFilterList(kAdBlockEasyListFranceUUID, false);
+  EXPECT_NE(engine_generation,
+            brave_shields::AdBlockBaseService::GetEngineGeneration());
+
+  ui_test_utils::NavigateToURL(browser(), url);
+  contents = browser()->tab_strip_model()->GetActiveWebContents();
+
+  ASSERT_EQ(true, EvalJs(contents,
+                         "setExpectations(1, 0, 0, 0);"
+                         "addImage('ad_fr.png')"));
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 1ULL);
+}
+
 // Load a page with an image which is not an ad, and make sure it is
 // NOT blocked by the regional blocker.
 IN_PROC_BROWSER_TEST_F(AdBlockServiceTest,
@@ -644,12 +681,17 @@ IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, CnameCloakedRequestsGetBlocked) {
 
   // XHR request to an unblocked first-party endpoint that is CNAME cloaked.
   // The canonical alias has no matching rule, so the request should be allowed.
+  base::HistogramTester histogram_tester;
   ASSERT_EQ(true, EvalJs(contents,
                          base::StringPrintf("setExpectations(0, 1, 1, 1);"
                                             "xhr('%s')",
                                             safe_resource_url.spec().c_str())));
   EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 2ULL);
-  ASSERT_EQ(4ULL, inner_resolver->num_resolve());
+  // a.com was already resolved for the root document, so the cached CNAME is
+  // used and no time is spent resolving it.
+  ASSERT_EQ(3ULL, inner_resolver->num_resolve());
+  histogram_tester.ExpectUniqueTimeSample(
+      "Brave.ShieldsCNAMEBlocking.TotalResolutionTime", base::TimeDelta(), 1);
 
   // XHR request directly to a blocked third-party endpoint.
   // The resolver should not be queried for this request.
@@ -658,7 +700,7 @@ IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, CnameCloakedRequestsGetBlocked) {
                                             "xhr('%s')",
                                             bad_resource_url.spec().c_str())));
   EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 3ULL);
-  ASSERT_EQ(4ULL, inner_resolver->num_resolve());
+  ASSERT_EQ(3ULL, inner_resolver->num_resolve());
 
   // Unset the host resolver so as not to interfere with later tests.
   brave::SetAdblockCnameHostResolverForTesting(nullptr);
@@ -734,7 +776,9 @@ IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, CnameCloakedRequestsCanBeExcepted) {
                                             "xhr('%s')",
                                             safe_resource_url.spec().c_str())));
   EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 2ULL);
-  ASSERT_EQ(4ULL, inner_resolver->num_resolve());
+  // a.com was already resolved for the root document, so the cached CNAME is
+  // used.
+  ASSERT_EQ(3ULL, inner_resolver->num_resolve());
 
   // XHR request directly to a blocked third-party endpoint.
   // The resolver should not be queried for this request.
@@ -743,7 +787,7 @@ IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, CnameCloakedRequestsCanBeExcepted) {
                                             "xhr('%s')",
                                             bad_resource_url.spec().c_str())));
   EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 3ULL);
-  ASSERT_EQ(4ULL, inner_resolver->num_resolve());
+  ASSERT_EQ(3ULL, inner_resolver->num_resolve());
 
   // Unset the host resolver so as not to interfere with later tests.
   brave::SetAdblockCnameHostResolverForTesting(nullptr);
@@ -7,6 +7,7 @@
 
 #include <string>
 
+#include "base/task/thread_pool.h"
 #include "brave/browser/brave_browser_process.h"
 #include "brave/browser/net/url_context.h"
 #include "brave/components/brave_shields/browser/ad_block_service.h"
@@ -77,7 +78,9 @@ int OnHeadersReceived_AdBlockCspWork(
     }
 
     scoped_refptr<base::SequencedTaskRunner> task_runner =
-        g_brave_browser_process->ad_block_service()->GetTaskRunner();
+        base::ThreadPool::CreateSequencedTaskRunner(
+            {base::TaskPriority::USER_BLOCKING,
+             base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN});
 
     std::string original_csp_string;
     base::Optional<std::string> original_csp = base::nullopt;
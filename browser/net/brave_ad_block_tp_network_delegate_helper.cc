@@ -5,19 +5,29 @@
 
 #include "brave/browser/net/brave_ad_block_tp_network_delegate_helper.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "base/base64url.h"
+#include "base/containers/mru_cache.h"
 #include "base/feature_list.h"
+#include "base/memory/ref_counted.h"
+#include "base/metrics/histogram_macros.h"
+#include "base/no_destructor.h"
+#include "base/optional.h"
 #include "base/strings/string_util.h"
+#include "base/task/thread_pool.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "base/time/time.h"
 #include "brave/browser/brave_browser_process.h"
 #include "brave/browser/brave_shields/brave_shields_web_contents_observer.h"
 #include "brave/browser/net/url_context.h"
 #include "brave/common/network_constants.h"
 #include "brave/common/url_constants.h"
+#include "brave/components/brave_shields/browser/ad_block_match_cache.h"
 #include "brave/components/brave_shields/browser/ad_block_service.h"
 #include "brave/components/brave_shields/common/brave_shield_constants.h"
 #include "brave/components/brave_shields/common/features.h"
@@ -32,6 +42,8 @@
 #include "content/public/common/url_constants.h"
 #include "extensions/common/url_pattern.h"
 #include "mojo/public/cpp/bindings/remote.h"
+#include "net/base/network_isolation_key.h"
+#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
 #include "services/network/host_resolver.h"
 #include "services/network/network_context.h"
 #include "ui/base/resource/resource_bundle.h"
@@ -41,17 +53,14 @@ namespace brave {
 
 network::HostResolver* g_testing_host_resolver;
 
-void SetAdblockCnameHostResolverForTesting(
-    network::HostResolver* host_resolver) {
-  g_testing_host_resolver = host_resolver;
-}
-
 // Used to keep track of state between a primary adblock engine query and one
 // after CNAME uncloaking the request.
 struct EngineFlags {
   bool did_match_rule = false;
   bool did_match_exception = false;
   bool did_match_important = false;
+  brave_shields::AdBlockFilterListSource matched_list =
+      brave_shields::AdBlockFilterListSource::kNone;
 };
 
 void UseCnameResult(scoped_refptr<base::SequencedTaskRunner> task_runner,
@@ -60,6 +69,113 @@ void UseCnameResult(scoped_refptr<base::SequencedTaskRunner> task_runner,
                     EngineFlags previous_result,
                     base::Optional<std::string> cname);
 
+// Joins the first engine query for a request with the CNAME lookup for its
+// host, and checks the uncloaked URL once both are done. The lookup either
+// starts alongside the engine query, or only once the engine has allowed the
+// request. Only used on the UI thread.
+class CnameUncloakRequest : public base::RefCounted<CnameUncloakRequest> {
+ public:
+  CnameUncloakRequest(scoped_refptr<base::SequencedTaskRunner> task_runner,
+                      const ResponseCallback& next_callback,
+                      std::shared_ptr<BraveRequestInfo> ctx);
+
+  // Looks up the CNAME of the request host, from the cache if possible
+  void Start();
+  // Called when the request was blocked without uncloaking it
+  void Cancel();
+  // Starts the lookup if it wasn't started alongside the engine query
+  void OnEngineResult(EngineFlags result);
+
+ private:
+  friend class base::RefCounted<CnameUncloakRequest>;
+  ~CnameUncloakRequest();
+
+  void OnCnameResolved(base::Optional<std::string> cname);
+  void OnCnameResult(base::Optional<std::string> cname);
+  void MaybeFinish();
+  bool CanUseCache() const;
+
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+  ResponseCallback next_callback_;
+  std::shared_ptr<BraveRequestInfo> ctx_;
+
+  bool started_ = false;
+  base::Optional<EngineFlags> engine_result_;
+  base::TimeTicks engine_result_time_;
+  bool has_cname_result_ = false;
+  base::Optional<std::string> cname_;
+  base::TimeTicks cname_result_time_;
+  bool finished_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(CnameUncloakRequest);
+};
+
+// How long a CNAME lookup is reused for. The resolver doesn't report record
+// TTLs, so this is kept shorter than the TTL of typical tracker records.
+constexpr base::TimeDelta kCnameCacheLifetime =
+    base::TimeDelta::FromMinutes(1);
+constexpr size_t kCnameCacheSize = 1000;
+
+// Remembers recent CNAME lookups, so that further requests to the same host
+// don't wait for DNS again. Entries are kept per network isolation key, like
+// the network service's own host cache. Only used on the UI thread.
+class CnameCache {
+ public:
+  CnameCache() : entries_(kCnameCacheSize) {}
+
+  // Returns true if |host| was resolved recently. |cname| is set to the
+  // canonical name, which is empty or |host| itself when there is no CNAME.
+  bool Get(const net::NetworkIsolationKey& network_isolation_key,
+           const std::string& host,
+           std::string* cname) {
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+    auto it = entries_.Get(Key(network_isolation_key, host));
+    if (it == entries_.end()) {
+      return false;
+    }
+    if (base::TimeTicks::Now() >= it->second.expiry) {
+      entries_.Erase(it);
+      return false;
+    }
+    *cname = it->second.cname;
+    return true;
+  }
+
+  void Put(const net::NetworkIsolationKey& network_isolation_key,
+           const std::string& host,
+           const std::string& cname) {
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+    entries_.Put(Key(network_isolation_key, host),
+                 Entry{cname, base::TimeTicks::Now() + kCnameCacheLifetime});
+  }
+
+  void Clear() { entries_.Clear(); }
+
+ private:
+  using Key = std::pair<net::NetworkIsolationKey, std::string>;
+
+  struct Entry {
+    std::string cname;
+    base::TimeTicks expiry;
+  };
+
+  base::MRUCache<Key, Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(CnameCache);
+};
+
+CnameCache* GetCnameCache() {
+  static base::NoDestructor<CnameCache> cname_cache;
+  return cname_cache.get();
+}
+
+void SetAdblockCnameHostResolverForTesting(
+    network::HostResolver* host_resolver) {
+  g_testing_host_resolver = host_resolver;
+  // Lookups made with a previous resolver shouldn't answer later requests
+  GetCnameCache()->Clear();
+}
+
 class AdblockCnameResolveHostClient : public network::mojom::ResolveHostClient {
  private:
   mojo::Receiver<network::mojom::ResolveHostClient> receiver_{this};
@@ -68,13 +184,10 @@ class AdblockCnameResolveHostClient : public network::mojom::ResolveHostClient {
 
  public:
   AdblockCnameResolveHostClient(
-      const ResponseCallback& next_callback,
-      scoped_refptr<base::SequencedTaskRunner> task_runner,
       std::shared_ptr<BraveRequestInfo> ctx,
-      EngineFlags previous_result) {
+      base::OnceCallback<void(base::Optional<std::string>)> cb)
+      : cb_(std::move(cb)) {
     DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
-    cb_ = base::BindOnce(&UseCnameResult, task_runner, std::move(next_callback),
-                         ctx, previous_result);
 
     const auto network_isolation_key = ctx->network_isolation_key;
 
@@ -142,6 +255,11 @@ class AdblockCnameResolveHostClient : public network::mojom::ResolveHostClient {
   }
 };
 
+bool IsBlockedByEngine(const EngineFlags& result) {
+  return result.did_match_important ||
+         (result.did_match_rule && !result.did_match_exception);
+}
+
 // If `canonical_url` is specified, this will only check if the CNAME-uncloaked
 // response should be blocked. Otherwise, it will run the check for the
 // original request URL.
@@ -164,20 +282,20 @@ EngineFlags ShouldBlockRequestOnTaskRunner(
   g_brave_browser_process->ad_block_service()->ShouldStartRequest(
       url_to_check, ctx->resource_type, source_host,
       &previous_result.did_match_rule, &previous_result.did_match_exception,
-      &previous_result.did_match_important, &ctx->mock_data_url);
+      &previous_result.did_match_important, &ctx->mock_data_url,
+      &previous_result.matched_list);
 
-  if (previous_result.did_match_important ||
-      (previous_result.did_match_rule &&
-       !previous_result.did_match_exception)) {
+  if (IsBlockedByEngine(previous_result)) {
     ctx->blocked_by = kAdBlocked;
+    UMA_HISTOGRAM_ENUMERATION("Brave.Shields.AdBlockMatchedList",
+                              previous_result.matched_list);
   }
 
   return previous_result;
 }
 
 void OnShouldBlockRequestResult(
-    bool then_check_uncloaked,
-    scoped_refptr<base::SequencedTaskRunner> task_runner,
+    scoped_refptr<CnameUncloakRequest> uncloak_request,
     const ResponseCallback& next_callback,
     std::shared_ptr<BraveRequestInfo> ctx,
     EngineFlags result) {
@@ -185,15 +303,41 @@ void OnShouldBlockRequestResult(
   if (ctx->blocked_by == kAdBlocked) {
     brave_shields::BraveShieldsWebContentsObserver::DispatchBlockedEvent(
         ctx->request_url, ctx->frame_tree_node_id, brave_shields::kAds);
-  } else if (then_check_uncloaked) {
-    // This will be deleted by `AdblockCnameResolveHostClient::OnComplete`.
-    new AdblockCnameResolveHostClient(std::move(next_callback), task_runner,
-                                      ctx, result);
+    if (uncloak_request) {
+      uncloak_request->Cancel();
+    }
+  } else if (uncloak_request) {
+    uncloak_request->OnEngineResult(result);
     return;
   }
   next_callback.Run();
 }
 
+// Stores the result of checking the original request URL, so that repeats of
+// the request can skip the engine query.
+void OnPrimaryMatchResult(
+    uint64_t engine_generation,
+    base::TimeTicks start_time,
+    scoped_refptr<CnameUncloakRequest> uncloak_request,
+    const ResponseCallback& next_callback,
+    std::shared_ptr<BraveRequestInfo> ctx,
+    EngineFlags result) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  brave_shields::AdBlockMatchCache::Result cached;
+  cached.did_match_rule = result.did_match_rule;
+  cached.did_match_exception = result.did_match_exception;
+  cached.did_match_important = result.did_match_important;
+  cached.mock_data_url = ctx->mock_data_url;
+  cached.matched_list = result.matched_list;
+  cached.query_time = base::TimeTicks::Now() - start_time;
+  g_brave_browser_process->ad_block_service()->match_cache()->Put(
+      ctx->request_url, ctx->initiator_url.host(), ctx->resource_type,
+      engine_generation, cached);
+
+  OnShouldBlockRequestResult(std::move(uncloak_request), next_callback, ctx,
+                             result);
+}
+
 void UseCnameResult(scoped_refptr<base::SequencedTaskRunner> task_runner,
                     const ResponseCallback& next_callback,
                     std::shared_ptr<BraveRequestInfo> ctx,
@@ -212,13 +356,100 @@ void UseCnameResult(scoped_refptr<base::SequencedTaskRunner> task_runner,
         FROM_HERE,
         base::BindOnce(&ShouldBlockRequestOnTaskRunner, ctx, previous_result,
                        base::make_optional<GURL>(canonical_url)),
-        base::BindOnce(&OnShouldBlockRequestResult, false, task_runner,
-                       next_callback, ctx));
+        base::BindOnce(&OnShouldBlockRequestResult,
+                       scoped_refptr<CnameUncloakRequest>(), next_callback,
+                       ctx));
   } else {
     next_callback.Run();
   }
 }
 
+CnameUncloakRequest::CnameUncloakRequest(
+    scoped_refptr<base::SequencedTaskRunner> task_runner,
+    const ResponseCallback& next_callback,
+    std::shared_ptr<BraveRequestInfo> ctx)
+    : task_runner_(std::move(task_runner)),
+      next_callback_(next_callback),
+      ctx_(ctx) {}
+
+CnameUncloakRequest::~CnameUncloakRequest() = default;
+
+void CnameUncloakRequest::Start() {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  DCHECK(!started_);
+  started_ = true;
+  const std::string host = ctx_->request_url.host();
+  std::string cname;
+  if (CanUseCache() &&
+      GetCnameCache()->Get(ctx_->network_isolation_key, host, &cname)) {
+    // Recorded so that the histogram reflects requests that no longer wait
+    // for DNS
+    UMA_HISTOGRAM_TIMES("Brave.ShieldsCNAMEBlocking.TotalResolutionTime",
+                        base::TimeDelta());
+    OnCnameResult(cname);
+    return;
+  }
+
+  // This will be deleted by `AdblockCnameResolveHostClient::OnComplete`.
+  new AdblockCnameResolveHostClient(
+      ctx_, base::BindOnce(&CnameUncloakRequest::OnCnameResolved,
+                           base::WrapRefCounted(this)));
+}
+
+void CnameUncloakRequest::Cancel() {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  finished_ = true;
+}
+
+void CnameUncloakRequest::OnEngineResult(EngineFlags result) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  engine_result_ = result;
+  engine_result_time_ = base::TimeTicks::Now();
+  if (!started_) {
+    Start();
+    return;
+  }
+  MaybeFinish();
+}
+
+void CnameUncloakRequest::OnCnameResolved(base::Optional<std::string> cname) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  // Failed lookups aren't cached, so that they are retried on the next request
+  if (cname.has_value() && CanUseCache()) {
+    GetCnameCache()->Put(ctx_->network_isolation_key,
+                         ctx_->request_url.host(), *cname);
+  }
+  OnCnameResult(std::move(cname));
+}
+
+void CnameUncloakRequest::OnCnameResult(base::Optional<std::string> cname) {
+  cname_ = std::move(cname);
+  cname_result_time_ = base::TimeTicks::Now();
+  has_cname_result_ = true;
+  MaybeFinish();
+}
+
+void CnameUncloakRequest::MaybeFinish() {
+  if (finished_ || !engine_result_ || !has_cname_result_) {
+    return;
+  }
+  finished_ = true;
+
+  // Only the time the request was held up waiting for DNS after matching.
+  // Cache hits and lookups that finish before matching record zero
+  UMA_HISTOGRAM_TIMES(
+      "Brave.ShieldsCNAMEBlocking.WaitTimeAfterMatch",
+      std::max(base::TimeDelta(), cname_result_time_ - engine_result_time_));
+
+  UseCnameResult(task_runner_, next_callback_, ctx_, *engine_result_,
+                 std::move(cname_));
+}
+
+bool CnameUncloakRequest::CanUseCache() const {
+  // Lookups made for off-the-record profiles aren't shared with other ones
+  return !ctx_->browser_context->IsOffTheRecord();
+}
+
 void OnBeforeURLRequestAdBlockTP(const ResponseCallback& next_callback,
                                  std::shared_ptr<BraveRequestInfo> ctx) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
@@ -226,8 +457,13 @@ void OnBeforeURLRequestAdBlockTP(const ResponseCallback& next_callback,
   DCHECK(!ctx->request_url.is_empty());
   DCHECK(!ctx->initiator_url.is_empty());
 
+  // Matching reads an immutable engine snapshot, so requests are checked on
+  // their own sequence instead of queueing behind each other on the ad-block
+  // service's task runner.
   scoped_refptr<base::SequencedTaskRunner> task_runner =
-      g_brave_browser_process->ad_block_service()->GetTaskRunner();
+      base::ThreadPool::CreateSequencedTaskRunner(
+          {base::TaskPriority::USER_BLOCKING,
+           base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN});
 
   DCHECK(ctx->browser_context);
 
@@ -235,12 +471,66 @@ void OnBeforeURLRequestAdBlockTP(const ResponseCallback& next_callback,
   // skip it.
   bool should_check_uncloaked = !ctx->browser_context->IsTor();
 
+  // Read before matching, so that an engine published in the meantime makes
+  // the stored result stale instead of mislabelling it
+  const uint64_t engine_generation =
+      brave_shields::AdBlockBaseService::GetEngineGeneration();
+  brave_shields::AdBlockMatchCache::Result cached;
+  const bool cache_hit =
+      g_brave_browser_process->ad_block_service()->match_cache()->Get(
+          ctx->request_url, ctx->initiator_url.host(), ctx->resource_type,
+          engine_generation, &cached);
+  UMA_HISTOGRAM_BOOLEAN("Brave.OnBeforeURLRequest_AdBlockCacheHit", cache_hit);
+
+  EngineFlags cached_result;
+  if (cache_hit) {
+    cached_result.did_match_rule = cached.did_match_rule;
+    cached_result.did_match_exception = cached.did_match_exception;
+    cached_result.did_match_important = cached.did_match_important;
+    cached_result.matched_list = cached.matched_list;
+  }
+
+  // CNAME cloaking disguises third-party trackers as first-party hosts, so
+  // lookups for same-site hosts run alongside the engine query, overlapping DNS
+  // latency with matching. Other hosts are only resolved once the engine has
+  // allowed the request, so that blocked hosts never reach the resolver. No
+  // lookup is needed when the request is already known to be blocked.
+  scoped_refptr<CnameUncloakRequest> uncloak_request;
+  if (should_check_uncloaked &&
+      !(cache_hit && IsBlockedByEngine(cached_result))) {
+    uncloak_request = base::MakeRefCounted<CnameUncloakRequest>(
+        task_runner, next_callback, ctx);
+    if (net::registry_controlled_domains::SameDomainOrHost(
+            ctx->request_url, ctx->initiator_url,
+            net::registry_controlled_domains::INCLUDE_PRIVATE_REGISTRIES)) {
+      uncloak_request->Start();
+    }
+  }
+
+  if (cache_hit) {
+    UMA_HISTOGRAM_TIMES("Brave.OnBeforeURLRequest_AdBlockCacheSavedTime",
+                        cached.query_time);
+    ctx->mock_data_url = cached.mock_data_url;
+    if (IsBlockedByEngine(cached_result)) {
+      ctx->blocked_by = kAdBlocked;
+      UMA_HISTOGRAM_ENUMERATION("Brave.Shields.AdBlockMatchedList",
+                                cached_result.matched_list);
+    }
+    // Callers expect the result to arrive after this returns
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&OnShouldBlockRequestResult, uncloak_request,
+                       next_callback, ctx, cached_result));
+    return;
+  }
+
   task_runner->PostTaskAndReplyWithResult(
       FROM_HERE,
       base::BindOnce(&ShouldBlockRequestOnTaskRunner, ctx, EngineFlags(),
                      base::nullopt),
-      base::BindOnce(&OnShouldBlockRequestResult, should_check_uncloaked,
-                     task_runner, next_callback, ctx));
+      base::BindOnce(&OnPrimaryMatchResult, engine_generation,
+                     base::TimeTicks::Now(), uncloak_request, next_callback,
+                     ctx));
 }
 
 int OnBeforeURLRequest_AdBlockTPPreWork(const ResponseCallback& next_callback,
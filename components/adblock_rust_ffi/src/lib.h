@@ -50,6 +50,28 @@ void engine_match(struct C_Engine *engine,
                   bool *did_match_important,
                   char **redirect);
 
+/**
+ * Checks if a `url` matches for each of the `engine_count` specified `Engine`s in order, within
+ * the context.
+ *
+ * This gives the same results as calling `engine_match` on each engine in turn and stopping once
+ * an important rule matched, but crosses the FFI boundary and validates the request strings only
+ * once. `matched_engine` is set to the index of the last engine that matched a rule, exception or
+ * important rule, or -1 if none of them did.
+ */
+void engines_match(struct C_Engine *const *engines,
+                   size_t engine_count,
+                   const char *url,
+                   const char *host,
+                   const char *tab_host,
+                   bool third_party,
+                   const char *resource_type,
+                   bool *did_match_rule,
+                   bool *did_match_exception,
+                   bool *did_match_important,
+                   int32_t *matched_engine,
+                   char **redirect);
+
 /**
  * Returns any CSP directives that should be added to a subdocument or document request's response
  * headers.
@@ -74,7 +74,8 @@ pub unsafe extern "C" fn engine_match(
     let tab_host = CStr::from_ptr(tab_host).to_str().unwrap();
     let resource_type = CStr::from_ptr(resource_type).to_str().unwrap();
     assert!(!engine.is_null());
-    let engine = Box::leak(Box::from_raw(engine));
+    // Matching only reads the engine, so it may run on several threads at once
+    let engine = &*engine;
     let blocker_result = engine.check_network_urls_with_hostnames_subset(
         url,
         host,
@@ -98,6 +99,74 @@ pub unsafe extern "C" fn engine_match(
     };
 }
 
+/// Checks if a `url` matches for each of the `engine_count` specified `Engine`s in order, within
+/// the context.
+///
+/// This gives the same results as calling `engine_match` on each engine in turn and stopping once
+/// an important rule matched, but crosses the FFI boundary and validates the request strings only
+/// once. `matched_engine` is set to the index of the last engine that matched a rule, exception or
+/// important rule, or -1 if none of them did.
+#[no_mangle]
+pub unsafe extern "C" fn engines_match(
+    engines: *const *mut Engine,
+    engine_count: size_t,
+    url: *const c_char,
+    host: *const c_char,
+    tab_host: *const c_char,
+    third_party: bool,
+    resource_type: *const c_char,
+    did_match_rule: *mut bool,
+    did_match_exception: *mut bool,
+    did_match_important: *mut bool,
+    matched_engine: *mut i32,
+    redirect: *mut *mut c_char,
+) {
+    let url = CStr::from_ptr(url).to_str().unwrap();
+    let host = CStr::from_ptr(host).to_str().unwrap();
+    let tab_host = CStr::from_ptr(tab_host).to_str().unwrap();
+    let resource_type = CStr::from_ptr(resource_type).to_str().unwrap();
+    assert!(!engines.is_null() || engine_count == 0);
+    *matched_engine = -1;
+    *redirect = ptr::null_mut();
+    if engine_count == 0 {
+        return;
+    }
+    let engines = std::slice::from_raw_parts(engines, engine_count);
+    let mut redirect_result: Option<String> = None;
+    for (index, engine) in engines.iter().enumerate() {
+        assert!(!engine.is_null());
+        let engine = &**engine;
+        let blocker_result = engine.check_network_urls_with_hostnames_subset(
+            url,
+            host,
+            tab_host,
+            resource_type,
+            Some(third_party),
+            // Checking normal rules is skipped if a normal rule or exception rule was found previously
+            *did_match_rule || *did_match_exception,
+            // Always check exceptions unless one was found previously
+            !*did_match_exception,
+        );
+        if blocker_result.matched || blocker_result.exception.is_some() || blocker_result.important {
+            *matched_engine = index as i32;
+        }
+        *did_match_rule |= blocker_result.matched;
+        *did_match_exception |= blocker_result.exception.is_some();
+        *did_match_important |= blocker_result.important;
+        if blocker_result.redirect.is_some() {
+            redirect_result = blocker_result.redirect;
+        }
+        if *did_match_important {
+            break;
+        }
+    }
+    if let Some(x) = redirect_result {
+        if let Ok(y) = CString::new(x) {
+            *redirect = y.into_raw();
+        }
+    }
+}
+
 /// Returns any CSP directives that should be added to a subdocument or document request's response
 /// headers.
 #[no_mangle]
@@ -114,7 +183,7 @@ pub unsafe extern "C" fn engine_get_csp_directives(
     let tab_host = CStr::from_ptr(tab_host).to_str().unwrap();
     let resource_type = CStr::from_ptr(resource_type).to_str().unwrap();
     assert!(!engine.is_null());
-    let engine = Box::leak(Box::from_raw(engine));
+    let engine = &*engine;
     if let Some(directive) = engine.get_csp_directives(url, host, tab_host, resource_type, Some(third_party)) {
         let ptr = CString::new(directive)
             .expect("Error: CString::new()")
@@ -233,7 +302,7 @@ pub unsafe extern "C" fn engine_url_cosmetic_resources(
 ) -> *mut c_char {
     let url = CStr::from_ptr(url).to_str().unwrap();
     assert!(!engine.is_null());
-    let engine = Box::leak(Box::from_raw(engine));
+    let engine = &*engine;
     let ptr = CString::new(serde_json::to_string(&engine.url_cosmetic_resources(url))
         .unwrap_or_else(|_| "".into()))
         .expect("Error: CString::new()")
@@ -268,7 +337,7 @@ pub unsafe extern "C" fn engine_hidden_class_id_selectors(
         .map(|index| CStr::from_ptr(exceptions[index]).to_str().unwrap().to_owned())
         .collect();
     assert!(!engine.is_null());
-    let engine = Box::leak(Box::from_raw(engine));
+    let engine = &*engine;
     let stylesheet = engine.hidden_class_id_selectors(&classes, &ids, &exceptions);
     CString::new(serde_json::to_string(&stylesheet).unwrap_or_else(|_| "".into())).expect("Error: CString::new()").into_raw()
 }
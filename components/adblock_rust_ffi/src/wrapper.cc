@@ -52,7 +52,7 @@ void Engine::matches(const std::string& url,
                      bool* did_match_rule,
                      bool* did_match_exception,
                      bool* did_match_important,
-                     std::string* redirect) {
+                     std::string* redirect) const {
   char* redirect_char_ptr = nullptr;
   engine_match(raw, url.c_str(), host.c_str(), tab_host.c_str(), is_third_party,
                resource_type.c_str(), did_match_rule, did_match_exception,
@@ -65,11 +65,46 @@ void Engine::matches(const std::string& url,
   }
 }
 
+// static
+void Engine::matchesAll(const std::vector<const Engine*>& engines,
+                        const std::string& url,
+                        const std::string& host,
+                        const std::string& tab_host,
+                        bool is_third_party,
+                        const std::string& resource_type,
+                        bool* did_match_rule,
+                        bool* did_match_exception,
+                        bool* did_match_important,
+                        int* matched_engine,
+                        std::string* redirect) {
+  std::vector<C_Engine*> engines_raw;
+  engines_raw.reserve(engines.size());
+  for (const Engine* engine : engines) {
+    engines_raw.push_back(engine->raw);
+  }
+
+  char* redirect_char_ptr = nullptr;
+  int32_t matched_engine_raw = -1;
+  engines_match(engines_raw.data(), engines_raw.size(), url.c_str(),
+                host.c_str(), tab_host.c_str(), is_third_party,
+                resource_type.c_str(), did_match_rule, did_match_exception,
+                did_match_important, &matched_engine_raw, &redirect_char_ptr);
+  if (matched_engine) {
+    *matched_engine = matched_engine_raw;
+  }
+  if (redirect_char_ptr) {
+    if (redirect) {
+      *redirect = redirect_char_ptr;
+    }
+    c_char_buffer_destroy(redirect_char_ptr);
+  }
+}
+
 std::string Engine::getCspDirectives(const std::string& url,
                                      const std::string& host,
                                      const std::string& tab_host,
                                      bool is_third_party,
-                                     const std::string& resource_type) {
+                                     const std::string& resource_type) const {
   char* csp_raw = engine_get_csp_directives(raw, url.c_str(), host.c_str(),
                                             tab_host.c_str(), is_third_party,
                                             resource_type.c_str());
@@ -105,7 +140,8 @@ void Engine::addResources(const std::string& resources) {
   engine_add_resources(raw, resources.c_str());
 }
 
-const std::string Engine::urlCosmeticResources(const std::string& url) {
+const std::string Engine::urlCosmeticResources(
+    const std::string& url) const {
   char* resources_raw = engine_url_cosmetic_resources(raw, url.c_str());
   const std::string resources_json = std::string(resources_raw);
 
@@ -116,7 +152,7 @@ const std::string Engine::urlCosmeticResources(const std::string& url) {
 const std::string Engine::hiddenClassIdSelectors(
     const std::vector<std::string>& classes,
     const std::vector<std::string>& ids,
-    const std::vector<std::string>& exceptions) {
+    const std::vector<std::string>& exceptions) const {
   std::vector<const char*> classes_raw;
   classes_raw.reserve(classes.size());
   for (size_t i = 0; i < classes.size(); i++) {
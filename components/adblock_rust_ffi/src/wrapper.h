@@ -76,12 +76,27 @@ class ADBLOCK_EXPORT Engine {
                bool* did_match_rule,
                bool* did_match_exception,
                bool* did_match_important,
-               std::string* redirect);
+               std::string* redirect) const;
+  // Checks |url| against each of |engines| in order, which gives the same
+  // result as calling matches() on each of them until an important rule
+  // matches. |matched_engine| is set to the index of the last engine that
+  // matched a rule, exception or important rule, or -1 if none did.
+  static void matchesAll(const std::vector<const Engine*>& engines,
+                         const std::string& url,
+                         const std::string& host,
+                         const std::string& tab_host,
+                         bool is_third_party,
+                         const std::string& resource_type,
+                         bool* did_match_rule,
+                         bool* did_match_exception,
+                         bool* did_match_important,
+                         int* matched_engine,
+                         std::string* redirect);
   std::string getCspDirectives(const std::string& url,
                                const std::string& host,
                                const std::string& tab_host,
                                bool is_third_party,
-                               const std::string& resource_type);
+                               const std::string& resource_type) const;
   bool deserialize(const char* data, size_t data_size);
   void addTag(const std::string& tag);
   void addResource(const std::string& key,
@@ -90,11 +105,11 @@ class ADBLOCK_EXPORT Engine {
   void addResources(const std::string& resources);
   void removeTag(const std::string& tag);
   bool tagExists(const std::string& tag);
-  const std::string urlCosmeticResources(const std::string& url);
+  const std::string urlCosmeticResources(const std::string& url) const;
   const std::string hiddenClassIdSelectors(
       const std::vector<std::string>& classes,
       const std::vector<std::string>& ids,
-      const std::vector<std::string>& exceptions);
+      const std::vector<std::string>& exceptions) const;
   ~Engine();
 
  private:
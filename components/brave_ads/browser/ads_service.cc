@@ -46,6 +46,7 @@ void AdsService::RegisterProfilePrefs(
 
   registry->RegisterBooleanPref(ads::prefs::kShouldAllowConversionTracking,
                                 true);
+  registry->RegisterStringPref(ads::prefs::kFullPageHtmlUrlPatterns, "[]");
 
   registry->RegisterUint64Pref(ads::prefs::kAdsPerHour, 0);
 
@@ -13,6 +13,11 @@ namespace features {
 const base::Feature kAdNotifications{"AdNotifications",
                                      base::FEATURE_ENABLED_BY_DEFAULT};
 
+// When enabled, the renderer extracts only the page content used by ads
+// instead of the serialized document and full text
+const base::Feature kCompactPageContent{"AdsCompactPageContent",
+                                        base::FEATURE_DISABLED_BY_DEFAULT};
+
 namespace {
 
 // Set to true to show custom ad notifications or false to show system
@@ -30,6 +35,12 @@ const int kDefaultAdNotificationTimeout = 120;
 const int kDefaultAdNotificationTimeout = 30;
 #endif
 
+// Maximum number of characters of page text to extract when compact page
+// content is enabled
+const char kFieldTrialParameterCompactPageContentMaxTextLength[] =
+    "max_text_length";
+const int kDefaultCompactPageContentMaxTextLength = 16384;
+
 #if !defined(OS_ANDROID)
 
 // Ad notification fade animation duration in milliseconds
@@ -108,6 +119,16 @@ int AdNotificationTimeout() {
       kDefaultAdNotificationTimeout);
 }
 
+bool IsCompactPageContentEnabled() {
+  return base::FeatureList::IsEnabled(kCompactPageContent);
+}
+
+int CompactPageContentMaxTextLength() {
+  return GetFieldTrialParamByFeatureAsInt(
+      kCompactPageContent, kFieldTrialParameterCompactPageContentMaxTextLength,
+      kDefaultCompactPageContentMaxTextLength);
+}
+
 #if !defined(OS_ANDROID)
 
 int AdNotificationFadeDuration() {
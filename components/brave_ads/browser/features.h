@@ -16,6 +16,7 @@ namespace brave_ads {
 namespace features {
 
 extern const base::Feature kAdNotifications;
+extern const base::Feature kCompactPageContent;
 
 bool IsAdNotificationsEnabled();
 
@@ -23,6 +24,10 @@ bool ShouldShowCustomAdNotifications();
 
 int AdNotificationTimeout();
 
+bool IsCompactPageContentEnabled();
+
+int CompactPageContentMaxTextLength();
+
 #if !defined(OS_ANDROID)
 
 int AdNotificationFadeDuration();
@@ -5,11 +5,14 @@
 
 #include "brave/components/brave_rewards/browser/diagnostic_log.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "base/files/file_util.h"
 #include "base/i18n/time_formatting.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/task/post_task.h"
@@ -17,8 +20,10 @@
 
 namespace {
 
-const int64_t kChunkSize = 1024;
+const int64_t kChunkSize = 64 * 1024;
 const size_t kDividerLength = 80;
+const size_t kMaxPendingLogEntriesSize = 64 * 1024;
+constexpr base::TimeDelta kFlushDelay = base::TimeDelta::FromSeconds(1);
 
 std::string FormatTime(const base::Time& time) {
   return base::UTF16ToUTF8(
@@ -48,261 +53,230 @@ std::string GetLogVerboseLevelName(int verbose_level) {
   return verbose_level_name;
 }
 
-bool Create(const base::FilePath& file_path, base::File* file) {
-  DCHECK(file);
+// Reads the last |num_lines| lines of |file_path| into |data|, or the entire
+// file if it has fewer lines or |num_lines| is -1. Returns the number of
+// lines read, or -1 on error. A missing file has no lines.
+int ReadLastNLinesOfFile(const base::FilePath& file_path,
+                         int num_lines,
+                         std::string* data) {
+  DCHECK(data);
 
-  file->Initialize(file_path, base::File::FLAG_CREATE_ALWAYS |
-                                  base::File::FLAG_READ |
-                                  base::File::FLAG_WRITE);
-
-  return file->IsValid();
-}
-
-bool Open(const base::FilePath& file_path, base::File* file) {
-  DCHECK(file);
-
-  file->Initialize(file_path, base::File::FLAG_OPEN | base::File::FLAG_READ |
-                                  base::File::FLAG_WRITE);
-
-  return file->IsValid();
-}
-
-bool CreateOrOpen(const base::FilePath& file_path, base::File* file) {
-  DCHECK(file);
-
-  if (!base::PathExists(file_path)) {
-    return Create(file_path, file);
-  }
-
-  if (!Open(file_path, file)) {
-    return false;
-  }
-
-  return file->IsValid();
-}
-
-int64_t SeekFromEnd(base::File* file, int num_lines) {
-  DCHECK(file);
-
-  if (!file->IsValid()) {
-    return 0;
-  }
-
-  if (num_lines == 0) {
+  base::File file(file_path, base::File::FLAG_OPEN | base::File::FLAG_READ);
+  if (!file.IsValid()) {
     return 0;
   }
 
-  int64_t length = file->GetLength();
+  const int64_t length = file.GetLength();
   if (length == -1) {
     return -1;
   }
 
-  if (length == 0) {
+  if (length == 0 || num_lines == 0) {
     return 0;
   }
 
   int line_count = 0;
+  int64_t offset = 0;
 
-  char chunk[kChunkSize];
-  int64_t chunk_size = kChunkSize;
-  int64_t last_chunk_size = 0;
+  if (num_lines != -1) {
+    std::vector<char> chunk(kChunkSize);
+    int64_t chunk_offset = length;
+    bool found = false;
 
-  if (file->Seek(base::File::FROM_END, 0) == -1) {
-    return -1;
-  }
+    do {
+      const int64_t chunk_size = std::min(kChunkSize, chunk_offset);
+      chunk_offset -= chunk_size;
 
-  do {
-    if (chunk_size > length) {
-      chunk_size = length;
-    }
-
-    const int64_t seek_offset = chunk_size + last_chunk_size;
-    if (file->Seek(base::File::FROM_CURRENT, -seek_offset) == -1) {
-      return -1;
-    }
+      if (file.Read(chunk_offset, chunk.data(),
+                    static_cast<int>(chunk_size)) != chunk_size) {
+        return -1;
+      }
 
-    if (file->ReadAtCurrentPos(chunk, chunk_size) == -1) {
-      return -1;
-    }
+      for (int64_t i = chunk_size - 1; i >= 0; i--) {
+        if (chunk[i] != '\n') {
+          continue;
+        }
 
-    for (int i = chunk_size - 1; i >= 0; i--) {
-      if (chunk[i] == '\n') {
         line_count++;
         if (line_count == num_lines + 1) {
-          return length;
+          offset = chunk_offset + i + 1;
+          line_count = num_lines;
+          found = true;
+          break;
         }
       }
-
-      length--;
-    }
-
-    last_chunk_size = chunk_size;
-  } while (length > 0);
-
-  return length;
-}
-
-bool TrimBeginningOfFile(base::File* file, int keep_num_lines) {
-  DCHECK(file);
-
-  if (file->GetLength() == 0) {
-    return true;
+    } while (!found && chunk_offset > 0);
   }
 
-  const int64_t offset = SeekFromEnd(file, keep_num_lines);
-  if (offset == -1) {
-    return false;
+  const int64_t size = length - offset;
+  data->resize(size);
+  if (file.Read(offset, &(*data)[0], static_cast<int>(size)) != size) {
+    return -1;
   }
 
-  if (offset == 0) {
-    return true;
-  }
+  return line_count;
+}
 
-  if (file->Seek(base::File::FROM_BEGIN, offset) == -1) {
-    return false;
-  }
+}  // namespace
 
-  const int64_t size = file->GetLength() - offset;
-  std::unique_ptr<char[]> buffer = std::make_unique<char[]>(size + 1);
+namespace brave_rewards {
 
-  if (file->ReadAtCurrentPos(buffer.get(), size) == -1) {
-    return false;
-  }
+// Owns the segments of the log, and keeps the segment being written to open
+// between writes. Must only be used on the file task runner.
+class DiagnosticLogFile {
+ public:
+  DiagnosticLogFile(const base::FilePath& file_path,
+                    int64_t max_segment_size,
+                    int num_segments)
+      : file_path_(file_path),
+        max_segment_size_(max_segment_size),
+        num_segments_(num_segments),
+        segment_size_(0) {}
+  DiagnosticLogFile(const DiagnosticLogFile&) = delete;
+  DiagnosticLogFile& operator=(const DiagnosticLogFile&) = delete;
+  ~DiagnosticLogFile() = default;
+
+  std::string ReadLastNLines(int num_lines) {
+    std::vector<std::string> segments;
+    int remaining_lines = num_lines;
+
+    for (int i = 0; i < num_segments_ && remaining_lines != 0; i++) {
+      std::string data;
+      const int line_count =
+          ReadLastNLinesOfFile(GetSegmentPath(i), remaining_lines, &data);
+      if (line_count == -1) {
+        return "";
+      }
 
-  if (file->Seek(base::File::FROM_BEGIN, 0) == -1) {
-    return false;
-  }
+      segments.push_back(std::move(data));
 
-  const std::string data = std::string(buffer.get());
-  const int64_t new_size = data.size();
+      if (remaining_lines != -1) {
+        remaining_lines -= line_count;
+      }
+    }
 
-  if (file->WriteAtCurrentPos(data.c_str(), new_size) == -1) {
-    return false;
-  }
+    std::string data;
+    for (auto iter = segments.rbegin(); iter != segments.rend(); ++iter) {
+      data += *iter;
+    }
 
-  if (!file->SetLength(new_size)) {
-    return false;
+    return data;
   }
 
-  return true;
-}
+  bool Append(const std::string& log_entries, bool first_write) {
+    if (!file_.IsValid() && !OpenSegment()) {
+      return false;
+    }
 
-bool MaybeTrimBeginningOfFile(base::File* file,
-                              int64_t max_file_size,
-                              int keep_num_lines,
-                              bool first_write) {
-  DCHECK(file);
+    std::string data;
+    if (first_write) {
+      data = std::string(kDividerLength, '-') + "\n";
+    }
+    data += log_entries;
 
-  const int64_t length = file->GetLength();
-  if (length == -1) {
-    return false;
-  }
+    const int64_t size = data.length();
+    if (segment_size_ > 0 && segment_size_ + size > max_segment_size_) {
+      if (!Rotate()) {
+        return false;
+      }
+    }
 
-  // We do not trim the log on first run so that if the browser
-  // crashes and we investigate the log with the user they are able to
-  // re-run the browser without losing past logs.
-  if (!first_write && length <= max_file_size) {
-    return true;
-  }
+    if (file_.WriteAtCurrentPos(data.c_str(), static_cast<int>(size)) !=
+        size) {
+      return false;
+    }
 
-  if (!TrimBeginningOfFile(file, keep_num_lines)) {
-    return false;
+    segment_size_ += size;
+    return true;
   }
 
-  return true;
-}
+  bool Delete() {
+    file_.Close();
+    segment_size_ = 0;
 
-std::string ReadLastNLinesOnFileTaskRunner(const base::FilePath& file_path,
-                                           int num_lines) {
-  base::File file;
-  if (!Open(file_path, &file)) {
-    return "";
-  }
+    bool result = true;
+    for (int i = 0; i < num_segments_; i++) {
+      if (!base::DeleteFile(GetSegmentPath(i))) {
+        result = false;
+      }
+    }
 
-  if (file.GetLength() == 0) {
-    return "";
+    return result;
   }
 
-  int64_t offset;
-
-  if (num_lines == -1) {
-    offset = 0;
-  } else {
-    offset = SeekFromEnd(&file, num_lines);
-    if (offset == -1) {
-      return "";
+ private:
+  base::FilePath GetSegmentPath(int index) const {
+    if (index == 0) {
+      return file_path_;
     }
-  }
 
-  if (file.Seek(base::File::FROM_BEGIN, offset) == -1) {
-    return "";
+    return file_path_.AddExtensionASCII(base::NumberToString(index));
   }
 
-  const int64_t size = file.GetLength() - offset;
-  std::unique_ptr<char[]> buffer = std::make_unique<char[]>(size + 1);
+  bool OpenSegment() {
+    file_.Initialize(file_path_,
+                     base::File::FLAG_OPEN_ALWAYS | base::File::FLAG_APPEND);
+    if (!file_.IsValid()) {
+      return false;
+    }
 
-  if (file.ReadAtCurrentPos(buffer.get(), size) == -1) {
-    return "";
+    segment_size_ = file_.GetLength();
+    return segment_size_ != -1;
   }
 
-  return std::string(buffer.get());
-}
-
-bool WriteOnFileTaskRunner(const base::FilePath& file_path,
-                           const std::string& log_entry,
-                           int64_t max_file_size,
-                           int keep_num_lines,
-                           bool first_write) {
-  base::File file;
-  if (!CreateOrOpen(file_path, &file)) {
-    return false;
-  }
+  // Drops the oldest segment and starts a new one
+  bool Rotate() {
+    file_.Close();
 
-  if (file.Seek(base::File::FROM_END, 0) == -1) {
-    return false;
-  }
+    if (!base::DeleteFile(GetSegmentPath(num_segments_ - 1))) {
+      return false;
+    }
 
-  if (first_write) {
-    const std::string divider = std::string(kDividerLength, '-') + "\n";
-    file.WriteAtCurrentPos(divider.c_str(), divider.length());
-  }
+    for (int i = num_segments_ - 1; i > 0; i--) {
+      const base::FilePath segment_path = GetSegmentPath(i - 1);
+      if (base::PathExists(segment_path) &&
+          !base::Move(segment_path, GetSegmentPath(i))) {
+        return false;
+      }
+    }
 
-  if (file.WriteAtCurrentPos(log_entry.c_str(), log_entry.length()) == -1) {
-    return false;
+    return OpenSegment();
   }
 
-  return MaybeTrimBeginningOfFile(&file, max_file_size, keep_num_lines,
-                                  first_write);
-}
-
-bool DeleteOnFileTaskRunner(const base::FilePath& file_path) {
-  return base::DeleteFile(file_path);
-}
-
-}  // namespace
-
-namespace brave_rewards {
+  const base::FilePath file_path_;
+  const int64_t max_segment_size_;
+  const int num_segments_;
+  base::File file_;
+  int64_t segment_size_;
+};
 
 DiagnosticLog::DiagnosticLog(const base::FilePath& file_path,
                              int64_t max_file_size,
-                             int keep_num_lines)
+                             int num_segments)
     : file_task_runner_(base::ThreadPool::CreateSequencedTaskRunner(
           {base::MayBlock(), base::TaskPriority::USER_VISIBLE,
            base::TaskShutdownBehavior::BLOCK_SHUTDOWN})),
-      file_path_(file_path),
-      max_file_size_(max_file_size),
-      keep_num_lines_(keep_num_lines),
-      first_write_(true) {}
+      log_file_(std::make_unique<DiagnosticLogFile>(file_path,
+                                                    max_file_size /
+                                                        num_segments,
+                                                    num_segments)),
+      first_write_(true) {
+  DCHECK_GT(num_segments, 0);
+}
 
 DiagnosticLog::~DiagnosticLog() {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  Flush();
+  file_task_runner_->DeleteSoon(FROM_HERE, log_file_.release());
 }
 
 void DiagnosticLog::ReadLastNLines(int num_lines, ReadCallback callback) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  Flush();
   file_task_runner_->PostTaskAndReplyWithResult(
       FROM_HERE,
-      base::BindOnce(&ReadLastNLinesOnFileTaskRunner, file_path_, num_lines),
+      base::BindOnce(&DiagnosticLogFile::ReadLastNLines,
+                     base::Unretained(log_file_.get()), num_lines),
       base::BindOnce(&DiagnosticLog::OnReadLastNLines, AsWeakPtr(),
                      std::move(callback)));
 }
@@ -310,13 +284,17 @@ void DiagnosticLog::ReadLastNLines(int num_lines, ReadCallback callback) {
 void DiagnosticLog::Write(const std::string& log_entry,
                           StatusCallback callback) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
-  file_task_runner_->PostTaskAndReplyWithResult(
-      FROM_HERE,
-      base::BindOnce(&WriteOnFileTaskRunner, file_path_, log_entry,
-                     max_file_size_, keep_num_lines_, first_write_),
-      base::BindOnce(&DiagnosticLog::OnWrite, AsWeakPtr(),
-                     std::move(callback)));
-  first_write_ = false;
+  pending_log_entries_ += log_entry;
+  pending_callbacks_.push_back(std::move(callback));
+
+  if (pending_log_entries_.length() >= kMaxPendingLogEntriesSize) {
+    Flush();
+    return;
+  }
+
+  if (!flush_timer_.IsRunning()) {
+    flush_timer_.Start(FROM_HERE, kFlushDelay, this, &DiagnosticLog::Flush);
+  }
 }
 
 void DiagnosticLog::Write(const std::string& log_entry,
@@ -342,21 +320,50 @@ void DiagnosticLog::Write(const std::string& log_entry,
 
 void DiagnosticLog::Delete(StatusCallback callback) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  Flush();
   file_task_runner_->PostTaskAndReplyWithResult(
-      FROM_HERE, base::BindOnce(&DeleteOnFileTaskRunner, file_path_),
+      FROM_HERE,
+      base::BindOnce(&DiagnosticLogFile::Delete,
+                     base::Unretained(log_file_.get())),
       base::BindOnce(&DiagnosticLog::OnDelete, AsWeakPtr(),
                      std::move(callback)));
 }
 
+void DiagnosticLog::Flush() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  flush_timer_.Stop();
+
+  if (pending_log_entries_.empty()) {
+    return;
+  }
+
+  std::string log_entries;
+  log_entries.swap(pending_log_entries_);
+  std::vector<StatusCallback> callbacks;
+  callbacks.swap(pending_callbacks_);
+
+  file_task_runner_->PostTaskAndReplyWithResult(
+      FROM_HERE,
+      base::BindOnce(&DiagnosticLogFile::Append,
+                     base::Unretained(log_file_.get()),
+                     std::move(log_entries), first_write_),
+      base::BindOnce(&DiagnosticLog::OnWrite, AsWeakPtr(),
+                     std::move(callbacks)));
+  first_write_ = false;
+}
+
 void DiagnosticLog::OnReadLastNLines(ReadCallback callback,
                                      const std::string& data) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
   std::move(callback).Run(data);
 }
 
-void DiagnosticLog::OnWrite(StatusCallback callback, bool result) {
+void DiagnosticLog::OnWrite(std::vector<StatusCallback> callbacks,
+                            bool result) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
-  std::move(callback).Run(result);
+  for (auto& callback : callbacks) {
+    std::move(callback).Run(result);
+  }
 }
 
 void DiagnosticLog::OnDelete(StatusCallback callback, bool result) {
@@ -0,0 +1,160 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/test/task_environment.h"
+#include "brave/components/brave_rewards/browser/diagnostic_log.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+// npm run test -- brave_unit_tests --filter=DiagnosticLogTest.*
+
+namespace brave_rewards {
+
+namespace {
+
+const char kDivider[] =
+    "----------------------------------------"
+    "----------------------------------------\n";
+
+}  // namespace
+
+class DiagnosticLogTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    file_path_ = temp_dir_.GetPath().AppendASCII("Rewards.log");
+  }
+
+  void TearDown() override {
+    // Closes the segment being written to before the directory is deleted
+    log_.reset();
+    task_environment_.RunUntilIdle();
+  }
+
+  void CreateLog(int64_t max_file_size, int num_segments) {
+    log_ = std::make_unique<DiagnosticLog>(file_path_, max_file_size,
+                                           num_segments);
+  }
+
+  void WriteAndWait(const std::string& log_entry) {
+    log_->Write(log_entry, base::BindOnce([](bool result) {
+                  EXPECT_TRUE(result);
+                }));
+    task_environment_.FastForwardUntilNoTasksRemain();
+  }
+
+  std::string ReadLastNLines(int num_lines) {
+    std::string result;
+    log_->ReadLastNLines(num_lines,
+                         base::BindOnce(
+                             [](std::string* result, const std::string& data) {
+                               *result = data;
+                             },
+                             &result));
+    task_environment_.RunUntilIdle();
+    return result;
+  }
+
+  std::string ReadFile(const base::FilePath& file_path) {
+    std::string data;
+    base::ReadFileToString(file_path, &data);
+    return data;
+  }
+
+  base::test::TaskEnvironment task_environment_{
+      base::test::TaskEnvironment::TimeSource::MOCK_TIME};
+  base::ScopedTempDir temp_dir_;
+  base::FilePath file_path_;
+  std::unique_ptr<DiagnosticLog> log_;
+};
+
+TEST_F(DiagnosticLogTest, WritesAreBatched) {
+  CreateLog(1024 * 1024, 2);
+
+  int write_count = 0;
+  auto callback = base::BindRepeating(
+      [](int* write_count, bool result) {
+        EXPECT_TRUE(result);
+        (*write_count)++;
+      },
+      &write_count);
+
+  log_->Write("line 1\n", callback);
+  log_->Write("line 2\n", callback);
+  task_environment_.RunUntilIdle();
+  EXPECT_EQ(write_count, 0);
+  EXPECT_FALSE(base::PathExists(file_path_));
+
+  task_environment_.FastForwardUntilNoTasksRemain();
+  EXPECT_EQ(write_count, 2);
+  EXPECT_EQ(ReadFile(file_path_),
+            std::string(kDivider) + "line 1\nline 2\n");
+}
+
+TEST_F(DiagnosticLogTest, ReadIncludesPendingEntries) {
+  CreateLog(1024 * 1024, 2);
+
+  log_->Write("line 1\n", base::DoNothing());
+  log_->Write("line 2\n", base::DoNothing());
+
+  EXPECT_EQ(ReadLastNLines(1), "line 2\n");
+  EXPECT_EQ(ReadLastNLines(-1), std::string(kDivider) + "line 1\nline 2\n");
+}
+
+TEST_F(DiagnosticLogTest, OldestSegmentIsDropped) {
+  // Each segment holds up to two entries
+  CreateLog(40, 2);
+
+  for (int i = 1; i <= 6; i++) {
+    WriteAndWait("line " + std::to_string(i) + "\n");
+  }
+
+  EXPECT_EQ(ReadFile(file_path_), "line 6\n");
+  EXPECT_EQ(ReadFile(file_path_.AddExtensionASCII("1")), "line 4\nline 5\n");
+  EXPECT_FALSE(base::PathExists(file_path_.AddExtensionASCII("2")));
+
+  EXPECT_EQ(ReadLastNLines(-1), "line 4\nline 5\nline 6\n");
+  EXPECT_EQ(ReadLastNLines(2), "line 5\nline 6\n");
+  EXPECT_EQ(ReadLastNLines(10), "line 4\nline 5\nline 6\n");
+}
+
+TEST_F(DiagnosticLogTest, ExistingLogIsKept) {
+  ASSERT_TRUE(base::WriteFile(file_path_, "previous\n"));
+  CreateLog(1024 * 1024, 2);
+
+  WriteAndWait("line 1\n");
+  EXPECT_EQ(ReadLastNLines(-1),
+            "previous\n" + std::string(kDivider) + "line 1\n");
+}
+
+TEST_F(DiagnosticLogTest, DeleteRemovesAllSegments) {
+  CreateLog(40, 2);
+
+  for (int i = 1; i <= 3; i++) {
+    WriteAndWait("line " + std::to_string(i) + "\n");
+  }
+  ASSERT_TRUE(base::PathExists(file_path_.AddExtensionASCII("1")));
+
+  bool deleted = false;
+  log_->Delete(base::BindOnce(
+      [](bool* deleted, bool result) {
+        *deleted = result;
+      },
+      &deleted));
+  task_environment_.RunUntilIdle();
+
+  EXPECT_TRUE(deleted);
+  EXPECT_FALSE(base::PathExists(file_path_));
+  EXPECT_FALSE(base::PathExists(file_path_.AddExtensionASCII("1")));
+  EXPECT_EQ(ReadLastNLines(-1), "");
+}
+
+}  // namespace brave_rewards
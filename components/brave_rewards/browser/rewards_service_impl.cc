@@ -100,7 +100,7 @@ static const unsigned int kRetriesCountOnNetworkChange = 1;
 namespace {
 
 const int kDiagnosticLogMaxVerboseLevel = 6;
-const int kDiagnosticLogKeepNumLines = 20000;
+const int kDiagnosticLogNumSegments = 4;
 const int kDiagnosticLogMaxFileSize = 10 * (1024 * 1024);
 const char pref_prefix[] = "brave.rewards";
 
@@ -325,7 +325,7 @@ RewardsServiceImpl::RewardsServiceImpl(Profile* profile)
       diagnostic_log_(
           new DiagnosticLog(profile_->GetPath().Append(kDiagnosticLogPath),
                             kDiagnosticLogMaxFileSize,
-                            kDiagnosticLogKeepNumLines)),
+                            kDiagnosticLogNumSegments)),
       notification_service_(new RewardsNotificationServiceImpl(profile)),
       next_timer_id_(0) {
   // Set up the rewards data source
@@ -6,13 +6,13 @@
 #include "brave/components/brave_shields/browser/ad_block_base_service.h"
 
 #include <algorithm>
+#include <atomic>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "base/bind.h"
 #include "base/files/file_path.h"
-#include "base/json/json_reader.h"
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
 #include "base/strings/utf_string_conversions.h"
@@ -23,94 +23,26 @@
 #include "brave/components/brave_shields/common/brave_shield_constants.h"
 #include "content/public/browser/browser_task_traits.h"
 #include "content/public/browser/browser_thread.h"
-#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
-#include "url/origin.h"
 
 using brave_component_updater::BraveComponent;
 using content::BrowserThread;
-using namespace net::registry_controlled_domains;  // NOLINT
+
+namespace brave_shields {
 
 namespace {
 
-std::string ResourceTypeToString(blink::mojom::ResourceType resource_type) {
-  std::string filter_option = "";
-  switch (resource_type) {
-    // top level page
-    case blink::mojom::ResourceType::kMainFrame:
-      filter_option = "main_frame";
-      break;
-    // frame or iframe
-    case blink::mojom::ResourceType::kSubFrame:
-      filter_option = "sub_frame";
-      break;
-    // a CSS stylesheet
-    case blink::mojom::ResourceType::kStylesheet:
-      filter_option = "stylesheet";
-      break;
-    // an external script
-    case blink::mojom::ResourceType::kScript:
-      filter_option = "script";
-      break;
-    // an image (jpg/gif/png/etc)
-    case blink::mojom::ResourceType::kFavicon:
-    case blink::mojom::ResourceType::kImage:
-      filter_option = "image";
-      break;
-    // a font
-    case blink::mojom::ResourceType::kFontResource:
-      filter_option = "font";
-      break;
-    // an "other" subresource.
-    case blink::mojom::ResourceType::kSubResource:
-      filter_option = "other";
-      break;
-    // an object (or embed) tag for a plugin.
-    case blink::mojom::ResourceType::kObject:
-      filter_option = "object";
-      break;
-    // a media resource.
-    case blink::mojom::ResourceType::kMedia:
-      filter_option = "media";
-      break;
-    // a XMLHttpRequest
-    case blink::mojom::ResourceType::kXhr:
-      filter_option = "xhr";
-      break;
-    // a ping request for <a ping>/sendBeacon.
-    case blink::mojom::ResourceType::kPing:
-      filter_option = "ping";
-      break;
-    // the main resource of a dedicated worker.
-    case blink::mojom::ResourceType::kWorker:
-    // the main resource of a shared worker.
-    case blink::mojom::ResourceType::kSharedWorker:
-    // an explicitly requested prefetch
-    case blink::mojom::ResourceType::kPrefetch:
-    // the main resource of a service worker.
-    case blink::mojom::ResourceType::kServiceWorker:
-    // a report of Content Security Policy violations.
-    case blink::mojom::ResourceType::kCspReport:
-    // a resource that a plugin requested.
-    case blink::mojom::ResourceType::kPluginResource:
-    default:
-      break;
-  }
-  return filter_option;
-}
+std::atomic<uint64_t> g_engine_generation{0};
 
 }  // namespace
 
-namespace brave_shields {
-
 AdBlockBaseService::AdBlockBaseService(BraveComponent::Delegate* delegate)
     : BaseBraveShieldsService(delegate),
-      ad_block_client_(new adblock::Engine()),
-      weak_factory_(this) {}
-
-AdBlockBaseService::~AdBlockBaseService() {
-  GetTaskRunner()->DeleteSoon(FROM_HERE, ad_block_client_.release());
+      weak_factory_(this) {
+  PublishEngine(std::make_unique<adblock::Engine>());
 }
 
+AdBlockBaseService::~AdBlockBaseService() {}
+
 void AdBlockBaseService::ShouldStartRequest(
     const GURL& url,
     blink::mojom::ResourceType resource_type,
@@ -119,100 +51,70 @@ void AdBlockBaseService::ShouldStartRequest(
     bool* did_match_exception,
     bool* did_match_important,
     std::string* mock_data_url) {
-  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
-
-  // Determine third-party here so the library doesn't need to figure it out.
-  // CreateFromNormalizedTuple is needed because SameDomainOrHost needs
-  // a URL or origin and not a string to a host name.
-  bool is_third_party = !SameDomainOrHost(
-      url,
-      url::Origin::CreateFromNormalizedTuple("https", tab_host.c_str(), 80),
-      INCLUDE_PRIVATE_REGISTRIES);
-  ad_block_client_->matches(
-      url.spec(), url.host(), tab_host, is_third_party,
-      ResourceTypeToString(resource_type), did_match_rule,
-      did_match_exception, did_match_important, mock_data_url);
-
-  // LOG(ERROR) << "AdBlockBaseService::ShouldStartRequest(), host: "
-  //  << tab_host
-  //  << ", resource type: " << resource_type
-  //  << ", url.spec(): " << url.spec();
+  GetEngine()->ShouldStartRequest(url, resource_type, tab_host, did_match_rule,
+                                  did_match_exception, did_match_important,
+                                  mock_data_url);
 }
 
 base::Optional<std::string> AdBlockBaseService::GetCspDirectives(
     const GURL& url,
     blink::mojom::ResourceType resource_type,
     const std::string& tab_host) {
-  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
-
-  // Determine third-party here so the library doesn't need to figure it out.
-  // CreateFromNormalizedTuple is needed because SameDomainOrHost needs
-  // a URL or origin and not a string to a host name.
-  bool is_third_party = !SameDomainOrHost(
-      url,
-      url::Origin::CreateFromNormalizedTuple("https", tab_host.c_str(), 80),
-      INCLUDE_PRIVATE_REGISTRIES);
-  const std::string result = ad_block_client_->getCspDirectives(
-      url.spec(), url.host(), tab_host, is_third_party,
-      ResourceTypeToString(resource_type));
-
-  if (result.empty()) {
-    return base::nullopt;
-  } else {
-    return base::Optional<std::string>(result);
-  }
+  return GetEngine()->GetCspDirectives(url, resource_type, tab_host);
 }
 
 void AdBlockBaseService::EnableTag(const std::string& tag, bool enabled) {
   if (BrowserThread::CurrentlyOn(BrowserThread::UI)) {
-    GetTaskRunner()->PostTask(
-        FROM_HERE, base::BindOnce(&AdBlockBaseService::EnableTag,
-                                  base::Unretained(this), tag, enabled));
+    QueueChange(base::BindOnce(&AdBlockBaseService::ApplyEnableTag,
+                               base::Unretained(this), tag, enabled));
     return;
   }
 
-  if (enabled) {
-    ad_block_client_->addTag(tag);
-    tags_.push_back(tag);
-  } else {
-    ad_block_client_->removeTag(tag);
-    std::vector<std::string>::iterator it =
-        std::find(tags_.begin(), tags_.end(), tag);
-    if (it != tags_.end()) {
-      tags_.erase(it);
-    }
-  }
+  ApplyEnableTag(tag, enabled);
+  RebuildEngine();
 }
 
 void AdBlockBaseService::AddResources(const std::string& resources) {
   if (BrowserThread::CurrentlyOn(BrowserThread::UI)) {
-    GetTaskRunner()->PostTask(
-        FROM_HERE, base::BindOnce(&AdBlockBaseService::AddResources,
-                                  base::Unretained(this), resources));
+    QueueChange(base::BindOnce(&AdBlockBaseService::ApplyAddResources,
+                               base::Unretained(this), resources));
     return;
   }
 
-  ad_block_client_->addResources(resources);
-  resources_ = resources;
+  ApplyAddResources(resources);
+  RebuildEngine();
 }
 
 bool AdBlockBaseService::TagExists(const std::string& tag) {
+  base::AutoLock lock(tags_lock_);
   return std::find(tags_.begin(), tags_.end(), tag) != tags_.end();
 }
 
 base::Optional<base::Value> AdBlockBaseService::UrlCosmeticResources(
         const std::string& url) {
-  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
-  return base::JSONReader::Read(ad_block_client_->urlCosmeticResources(url));
+  return GetEngine()->UrlCosmeticResources(url);
 }
 
 base::Optional<base::Value> AdBlockBaseService::HiddenClassIdSelectors(
         const std::vector<std::string>& classes,
         const std::vector<std::string>& ids,
         const std::vector<std::string>& exceptions) {
-  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
-  return base::JSONReader::Read(
-      ad_block_client_->hiddenClassIdSelectors(classes, ids, exceptions));
+  return GetEngine()->HiddenClassIdSelectors(classes, ids, exceptions);
+}
+
+scoped_refptr<AdBlockEngineSnapshot> AdBlockBaseService::GetEngine() const {
+  base::AutoLock lock(engine_lock_);
+  return engine_;
+}
+
+// static
+uint64_t AdBlockBaseService::GetEngineGeneration() {
+  return g_engine_generation.load(std::memory_order_acquire);
+}
+
+// static
+void AdBlockBaseService::InvalidateEngineGeneration() {
+  g_engine_generation.fetch_add(1, std::memory_order_release);
 }
 
 void AdBlockBaseService::GetDATFileData(const base::FilePath& dat_file_path) {
@@ -236,24 +138,122 @@ void AdBlockBaseService::OnGetDATFileData(GetDATFileDataResult result) {
   GetTaskRunner()->PostTask(
       FROM_HERE, base::BindOnce(&AdBlockBaseService::UpdateAdBlockClient,
                                 base::Unretained(this),
-                                std::move(result.first)));
+                                std::move(result.first),
+                                std::move(result.second)));
 }
 
 void AdBlockBaseService::UpdateAdBlockClient(
-    std::unique_ptr<adblock::Engine> ad_block_client) {
+    std::unique_ptr<adblock::Engine> ad_block_client,
+    brave_component_updater::DATFileDataBuffer dat_buffer) {
   DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
-  ad_block_client_ = std::move(ad_block_client);
-  AddKnownTagsToAdBlockInstance();
-  AddKnownResourcesToAdBlockInstance();
+  dat_buffer_ = std::move(dat_buffer);
+  rules_.clear();
+  AddKnownTagsAndResources(ad_block_client.get());
+  PublishEngine(std::move(ad_block_client));
 }
 
-void AdBlockBaseService::AddKnownTagsToAdBlockInstance() {
-  std::for_each(tags_.begin(), tags_.end(),
-                [&](const std::string tag) { ad_block_client_->addTag(tag); });
+void AdBlockBaseService::UpdateFilterRules(const std::string& rules) {
+  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
+  dat_buffer_.clear();
+  rules_ = rules;
+  PublishEngine(BuildEngine());
 }
 
-void AdBlockBaseService::AddKnownResourcesToAdBlockInstance() {
-  ad_block_client_->addResources(resources_);
+std::unique_ptr<adblock::Engine> AdBlockBaseService::BuildEngine() const {
+  std::unique_ptr<adblock::Engine> engine;
+  if (dat_buffer_.empty()) {
+    engine = std::make_unique<adblock::Engine>(rules_);
+  } else {
+    engine = std::make_unique<adblock::Engine>();
+    if (!engine->deserialize(
+            reinterpret_cast<const char*>(&dat_buffer_.front()),
+            dat_buffer_.size())) {
+      LOG(ERROR) << "Failed to deserialize ad block data";
+      return nullptr;
+    }
+  }
+  AddKnownTagsAndResources(engine.get());
+  return engine;
+}
+
+void AdBlockBaseService::AddKnownTagsAndResources(
+    adblock::Engine* engine) const {
+  {
+    base::AutoLock lock(tags_lock_);
+    std::for_each(tags_.begin(), tags_.end(),
+                  [&](const std::string tag) { engine->addTag(tag); });
+  }
+  engine->addResources(resources_);
+}
+
+void AdBlockBaseService::PublishEngine(
+    std::unique_ptr<adblock::Engine> engine) {
+  auto snapshot = base::MakeRefCounted<AdBlockEngineSnapshot>(
+      std::move(engine), GetTaskRunner());
+
+  // The previous snapshot is released outside of the lock, and is destroyed
+  // once the last request matching against it has finished
+  {
+    base::AutoLock lock(engine_lock_);
+    engine_.swap(snapshot);
+  }
+  // Only changed once the new engine is visible, so a result stored with the
+  // new generation can't have come from the previous engine
+  InvalidateEngineGeneration();
+}
+
+// Several tags and resources are usually changed in a row on startup. Changes
+// made before the posted task runs join its batch, so they are all applied to
+// a single new engine, which is published before the task returns
+void AdBlockBaseService::QueueChange(base::OnceClosure change) {
+  base::AutoLock lock(pending_changes_lock_);
+  pending_changes_.push_back(std::move(change));
+  if (pending_changes_.size() > 1) {
+    return;
+  }
+  GetTaskRunner()->PostTask(
+      FROM_HERE, base::BindOnce(&AdBlockBaseService::ApplyPendingChanges,
+                                base::Unretained(this)));
+}
+
+void AdBlockBaseService::ApplyPendingChanges() {
+  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
+  std::vector<base::OnceClosure> changes;
+  {
+    base::AutoLock lock(pending_changes_lock_);
+    changes.swap(pending_changes_);
+  }
+  for (auto& change : changes) {
+    std::move(change).Run();
+  }
+  RebuildEngine();
+}
+
+void AdBlockBaseService::ApplyEnableTag(const std::string& tag, bool enabled) {
+  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
+  base::AutoLock lock(tags_lock_);
+  if (enabled) {
+    tags_.push_back(tag);
+    return;
+  }
+  std::vector<std::string>::iterator it =
+      std::find(tags_.begin(), tags_.end(), tag);
+  if (it != tags_.end()) {
+    tags_.erase(it);
+  }
+}
+
+void AdBlockBaseService::ApplyAddResources(const std::string& resources) {
+  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
+  resources_ = resources;
+}
+
+void AdBlockBaseService::RebuildEngine() {
+  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
+  std::unique_ptr<adblock::Engine> engine = BuildEngine();
+  if (engine) {
+    PublishEngine(std::move(engine));
+  }
 }
 
 bool AdBlockBaseService::Init() {
@@ -265,12 +265,12 @@ void AdBlockBaseService::ResetForTest(const std::string& rules,
   // This is temporary until adblock-rust supports incrementally adding
   // filter rules to an existing instance. At which point the hack below
   // will dissapear.
-  ad_block_client_.reset(new adblock::Engine(rules));
-  AddKnownTagsToAdBlockInstance();
+  dat_buffer_.clear();
+  rules_ = rules;
   if (!resources.empty()) {
     resources_ = resources;
   }
-  AddKnownResourcesToAdBlockInstance();
+  PublishEngine(BuildEngine());
 }
 
 ///////////////////////////////////////////////////////////////////////////////
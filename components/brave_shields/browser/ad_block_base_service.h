@@ -13,10 +13,15 @@
 #include <utility>
 #include <vector>
 
+#include "base/callback.h"
 #include "base/files/file_path.h"
+#include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/sequence_checker.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
 #include "base/values.h"
+#include "brave/components/brave_shields/browser/ad_block_engine_snapshot.h"
 #include "brave/components/brave_shields/browser/base_brave_shields_service.h"
 #include "brave/components/brave_component_updater/browser/dat_file_util.h"
 #include "third_party/blink/public/mojom/loader/resource_load_info.mojom-shared.h"
@@ -31,7 +36,8 @@ class Engine;
 namespace brave_shields {
 
 // The base class of the brave shields service in charge of ad-block
-// checking and init.
+// checking and init. Requests are matched against the most recently published
+// engine snapshot and may be checked from any thread.
 class AdBlockBaseService : public BaseBraveShieldsService {
  public:
   using GetDATFileDataResult =
@@ -51,8 +57,12 @@ class AdBlockBaseService : public BaseBraveShieldsService {
       const GURL& url,
       blink::mojom::ResourceType resource_type,
       const std::string& tab_host);
+  // Changes made from the UI thread take effect once the task runner has been
+  // flushed. Changes made on GetTaskRunner() take effect immediately
   void AddResources(const std::string& resources);
   void EnableTag(const std::string& tag, bool enabled);
+  // May be called from any thread, but only reflects changes which have
+  // already been applied on GetTaskRunner()
   bool TagExists(const std::string& tag);
 
   virtual base::Optional<base::Value> UrlCosmeticResources(
@@ -62,25 +72,61 @@ class AdBlockBaseService : public BaseBraveShieldsService {
       const std::vector<std::string>& ids,
       const std::vector<std::string>& exceptions);
 
+  // Returns the engine snapshot which requests are currently matched against
+  scoped_refptr<AdBlockEngineSnapshot> GetEngine() const;
+
+  // Returns a number which changes whenever any ad-block service publishes a
+  // new engine, so that results from earlier engines can be told apart
+  static uint64_t GetEngineGeneration();
+  // Makes results from all current engines stale. Must be called whenever the
+  // set of services requests are matched against changes
+  static void InvalidateEngineGeneration();
+
  protected:
   friend class ::AdBlockServiceTest;
   bool Init() override;
 
   void GetDATFileData(const base::FilePath& dat_file_path);
-  void AddKnownTagsToAdBlockInstance();
-  void AddKnownResourcesToAdBlockInstance();
+  // Replaces the filter list with |rules|. Must be called on GetTaskRunner()
+  void UpdateFilterRules(const std::string& rules);
   void ResetForTest(const std::string& rules, const std::string& resources);
 
-  std::unique_ptr<adblock::Engine> ad_block_client_;
-
  private:
   void UpdateAdBlockClient(
-      std::unique_ptr<adblock::Engine> ad_block_client);
+      std::unique_ptr<adblock::Engine> ad_block_client,
+      brave_component_updater::DATFileDataBuffer dat_buffer);
   void OnGetDATFileData(GetDATFileDataResult result);
   void OnPreferenceChanges(const std::string& pref_name);
 
-  std::vector<std::string> tags_;
+  std::unique_ptr<adblock::Engine> BuildEngine() const;
+  void AddKnownTagsAndResources(adblock::Engine* engine) const;
+  void PublishEngine(std::unique_ptr<adblock::Engine> engine);
+  void QueueChange(base::OnceClosure change);
+  void ApplyPendingChanges();
+  void ApplyEnableTag(const std::string& tag, bool enabled);
+  void ApplyAddResources(const std::string& resources);
+  void RebuildEngine();
+
+  // Only held while a snapshot reference is copied or replaced, never while
+  // matching
+  mutable base::Lock engine_lock_;
+  scoped_refptr<AdBlockEngineSnapshot> engine_ GUARDED_BY(engine_lock_);
+
+  // What the published engine was built from, so that a new snapshot can be
+  // built when tags or resources change. Only used on GetTaskRunner()
+  brave_component_updater::DATFileDataBuffer dat_buffer_;
+  std::string rules_;
   std::string resources_;
+
+  // Only written on GetTaskRunner(), but also read by TagExists()
+  mutable base::Lock tags_lock_;
+  std::vector<std::string> tags_ GUARDED_BY(tags_lock_);
+
+  // Changes made from the UI thread which are waiting to be applied
+  base::Lock pending_changes_lock_;
+  std::vector<base::OnceClosure> pending_changes_
+      GUARDED_BY(pending_changes_lock_);
+
   base::WeakPtrFactory<AdBlockBaseService> weak_factory_;
   DISALLOW_COPY_AND_ASSIGN(AdBlockBaseService);
 };
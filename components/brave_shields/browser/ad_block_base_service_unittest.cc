@@ -0,0 +1,215 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/ad_block_base_service.h"
+
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "base/task/thread_pool.h"
+#include "brave/components/adblock_rust_ffi/src/wrapper.h"
+#include "brave/components/brave_shields/browser/ad_block_service_helper.h"
+#include "content/public/test/browser_task_environment.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+// npm run test -- brave_unit_tests --filter=AdBlockBaseServiceTest.*
+
+namespace brave_shields {
+
+namespace {
+
+const char kTag[] = "sup";
+
+const char kTaggedRule[] = "||tagged.example.com^$tag=sup";
+const char kRedirectRule[] = "js_mock_me.js$redirect=noopjs";
+
+const char kTaggedUrl[] = "https://tagged.example.com/logo.png";
+const char kRedirectUrl[] = "https://example.com/js_mock_me.js";
+
+const char kResources[] = R"(
+    [
+      {
+        "name": "noop.js",
+        "aliases": ["noopjs"],
+        "kind": {
+          "mime":"application/javascript"
+        },
+        "content": "KGZ1bmN0aW9uKCkgewogICAgJ3VzZSBzdHJpY3QnOwp9KSgpOwo="
+      }
+    ])";
+
+class TestBraveComponentDelegate : public BraveComponent::Delegate {
+ public:
+  TestBraveComponentDelegate()
+      : task_runner_(base::ThreadPool::CreateSequencedTaskRunner({})) {}
+  ~TestBraveComponentDelegate() override = default;
+
+  // BraveComponent::Delegate implementation
+  void Register(const std::string& component_name,
+                const std::string& component_base64_public_key,
+                base::OnceClosure registered_callback,
+                BraveComponent::ReadyCallback ready_callback) override {}
+  bool Unregister(const std::string& component_id) override { return true; }
+  void OnDemandUpdate(const std::string& component_id) override {}
+  void AddObserver(BraveComponent::ComponentObserver* observer) override {}
+  void RemoveObserver(BraveComponent::ComponentObserver* observer) override {}
+  scoped_refptr<base::SequencedTaskRunner> GetTaskRunner() override {
+    return task_runner_;
+  }
+  const std::string locale() const override { return "en"; }
+  PrefService* local_state() override { return nullptr; }
+
+ private:
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestBraveComponentDelegate);
+};
+
+class TestAdBlockService : public AdBlockBaseService {
+ public:
+  explicit TestAdBlockService(BraveComponent::Delegate* delegate)
+      : AdBlockBaseService(delegate) {}
+  ~TestAdBlockService() override = default;
+
+  using AdBlockBaseService::UpdateFilterRules;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TestAdBlockService);
+};
+
+}  // namespace
+
+class AdBlockBaseServiceTest : public testing::Test {
+ protected:
+  AdBlockBaseServiceTest()
+      : service_(std::make_unique<TestAdBlockService>(&delegate_)) {
+    adblock::SetDomainResolver(AdBlockServiceDomainResolver);
+  }
+
+  ~AdBlockBaseServiceTest() override {
+    // Old snapshots are destroyed on the service task runner
+    service_.reset();
+    task_environment_.RunUntilIdle();
+  }
+
+  void UpdateFilterRules(const std::string& rules) {
+    service_->GetTaskRunner()->PostTask(
+        FROM_HERE, base::BindOnce(&TestAdBlockService::UpdateFilterRules,
+                                  base::Unretained(service_.get()), rules));
+    task_environment_.RunUntilIdle();
+  }
+
+  void EnableTag(const std::string& tag, bool enabled) {
+    service_->EnableTag(tag, enabled);
+    task_environment_.RunUntilIdle();
+  }
+
+  void AddResources(const std::string& resources) {
+    service_->AddResources(resources);
+    task_environment_.RunUntilIdle();
+  }
+
+  bool IsBlocked(const std::string& url) {
+    bool did_match_rule = false;
+    bool did_match_exception = false;
+    bool did_match_important = false;
+    std::string mock_data_url;
+    service_->ShouldStartRequest(GURL(url), blink::mojom::ResourceType::kImage,
+                                 "brave.com", &did_match_rule,
+                                 &did_match_exception, &did_match_important,
+                                 &mock_data_url);
+    return did_match_rule && !did_match_exception;
+  }
+
+  std::string GetMockDataUrl(const std::string& url) {
+    bool did_match_rule = false;
+    bool did_match_exception = false;
+    bool did_match_important = false;
+    std::string mock_data_url;
+    service_->ShouldStartRequest(GURL(url), blink::mojom::ResourceType::kScript,
+                                 "brave.com", &did_match_rule,
+                                 &did_match_exception, &did_match_important,
+                                 &mock_data_url);
+    return mock_data_url;
+  }
+
+  content::BrowserTaskEnvironment task_environment_;
+  TestBraveComponentDelegate delegate_;
+  std::unique_ptr<TestAdBlockService> service_;
+};
+
+TEST_F(AdBlockBaseServiceTest, EnabledTagSurvivesRebuild) {
+  UpdateFilterRules(kTaggedRule);
+  EXPECT_FALSE(IsBlocked(kTaggedUrl));
+
+  EnableTag(kTag, true);
+  EXPECT_TRUE(service_->TagExists(kTag));
+  EXPECT_TRUE(IsBlocked(kTaggedUrl));
+
+  // Adding resources rebuilds the engine, which must keep the tag
+  AddResources(kResources);
+  EXPECT_TRUE(service_->TagExists(kTag));
+  EXPECT_TRUE(IsBlocked(kTaggedUrl));
+}
+
+TEST_F(AdBlockBaseServiceTest, DisabledTagSurvivesRebuild) {
+  UpdateFilterRules(kTaggedRule);
+  EnableTag(kTag, true);
+  EXPECT_TRUE(IsBlocked(kTaggedUrl));
+
+  EnableTag(kTag, false);
+  EXPECT_FALSE(service_->TagExists(kTag));
+  EXPECT_FALSE(IsBlocked(kTaggedUrl));
+
+  AddResources(kResources);
+  EXPECT_FALSE(service_->TagExists(kTag));
+  EXPECT_FALSE(IsBlocked(kTaggedUrl));
+}
+
+TEST_F(AdBlockBaseServiceTest, ResourcesSurviveRebuild) {
+  UpdateFilterRules(kRedirectRule);
+  EXPECT_TRUE(GetMockDataUrl(kRedirectUrl).empty());
+
+  AddResources(kResources);
+  const std::string mock_data_url = GetMockDataUrl(kRedirectUrl);
+  EXPECT_FALSE(mock_data_url.empty());
+
+  // Enabling a tag rebuilds the engine, which must keep the resources
+  EnableTag(kTag, true);
+  EXPECT_EQ(mock_data_url, GetMockDataUrl(kRedirectUrl));
+}
+
+TEST_F(AdBlockBaseServiceTest, ChangesMadeTogetherAreAllApplied) {
+  UpdateFilterRules(std::string(kTaggedRule) + "\n" + kRedirectRule);
+
+  // Both changes are queued before the task runner runs, so they are applied
+  // to a single new engine
+  service_->EnableTag(kTag, true);
+  service_->AddResources(kResources);
+  task_environment_.RunUntilIdle();
+
+  EXPECT_TRUE(IsBlocked(kTaggedUrl));
+  EXPECT_FALSE(GetMockDataUrl(kRedirectUrl).empty());
+}
+
+TEST_F(AdBlockBaseServiceTest, UpdateFilterRulesKeepsTagsAndResources) {
+  UpdateFilterRules("||unrelated.example.com^");
+  EnableTag(kTag, true);
+  AddResources(kResources);
+  EXPECT_FALSE(IsBlocked(kTaggedUrl));
+  EXPECT_TRUE(GetMockDataUrl(kRedirectUrl).empty());
+
+  UpdateFilterRules(std::string(kTaggedRule) + "\n" + kRedirectRule);
+
+  EXPECT_TRUE(service_->TagExists(kTag));
+  EXPECT_TRUE(IsBlocked(kTaggedUrl));
+  EXPECT_FALSE(GetMockDataUrl(kRedirectUrl).empty());
+  EXPECT_FALSE(IsBlocked("https://unrelated.example.com/logo.png"));
+}
+
+}  // namespace brave_shields
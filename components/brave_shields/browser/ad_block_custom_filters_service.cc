@@ -6,7 +6,6 @@
 #include "brave/components/brave_shields/browser/ad_block_custom_filters_service.h"
 
 #include "base/logging.h"
-#include "brave/components/adblock_rust_ffi/src/wrapper.h"
 #include "brave/components/brave_shields/browser/ad_block_service.h"
 #include "brave/components/brave_shields/common/pref_names.h"
 #include "components/prefs/pref_service.h"
@@ -84,7 +83,7 @@ bool AdBlockCustomFiltersService::MigrateLegacyCosmeticFilters(
 void AdBlockCustomFiltersService::UpdateCustomFiltersOnFileTaskRunner(
     const std::string& custom_filters) {
   DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
-  ad_block_client_.reset(new adblock::Engine(custom_filters.c_str()));
+  UpdateFilterRules(custom_filters);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
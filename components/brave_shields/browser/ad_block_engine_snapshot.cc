@@ -0,0 +1,179 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/ad_block_engine_snapshot.h"
+
+#include <utility>
+
+#include "base/json/json_reader.h"
+#include "brave/components/adblock_rust_ffi/src/wrapper.h"
+#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
+#include "url/origin.h"
+
+using namespace net::registry_controlled_domains;  // NOLINT
+
+namespace {
+
+std::string ResourceTypeToString(blink::mojom::ResourceType resource_type) {
+  std::string filter_option = "";
+  switch (resource_type) {
+    // top level page
+    case blink::mojom::ResourceType::kMainFrame:
+      filter_option = "main_frame";
+      break;
+    // frame or iframe
+    case blink::mojom::ResourceType::kSubFrame:
+      filter_option = "sub_frame";
+      break;
+    // a CSS stylesheet
+    case blink::mojom::ResourceType::kStylesheet:
+      filter_option = "stylesheet";
+      break;
+    // an external script
+    case blink::mojom::ResourceType::kScript:
+      filter_option = "script";
+      break;
+    // an image (jpg/gif/png/etc)
+    case blink::mojom::ResourceType::kFavicon:
+    case blink::mojom::ResourceType::kImage:
+      filter_option = "image";
+      break;
+    // a font
+    case blink::mojom::ResourceType::kFontResource:
+      filter_option = "font";
+      break;
+    // an "other" subresource.
+    case blink::mojom::ResourceType::kSubResource:
+      filter_option = "other";
+      break;
+    // an object (or embed) tag for a plugin.
+    case blink::mojom::ResourceType::kObject:
+      filter_option = "object";
+      break;
+    // a media resource.
+    case blink::mojom::ResourceType::kMedia:
+      filter_option = "media";
+      break;
+    // a XMLHttpRequest
+    case blink::mojom::ResourceType::kXhr:
+      filter_option = "xhr";
+      break;
+    // a ping request for <a ping>/sendBeacon.
+    case blink::mojom::ResourceType::kPing:
+      filter_option = "ping";
+      break;
+    // the main resource of a dedicated worker.
+    case blink::mojom::ResourceType::kWorker:
+    // the main resource of a shared worker.
+    case blink::mojom::ResourceType::kSharedWorker:
+    // an explicitly requested prefetch
+    case blink::mojom::ResourceType::kPrefetch:
+    // the main resource of a service worker.
+    case blink::mojom::ResourceType::kServiceWorker:
+    // a report of Content Security Policy violations.
+    case blink::mojom::ResourceType::kCspReport:
+    // a resource that a plugin requested.
+    case blink::mojom::ResourceType::kPluginResource:
+    default:
+      break;
+  }
+  return filter_option;
+}
+
+bool IsThirdParty(const GURL& url, const std::string& tab_host) {
+  // Determine third-party here so the library doesn't need to figure it out.
+  // CreateFromNormalizedTuple is needed because SameDomainOrHost needs
+  // a URL or origin and not a string to a host name.
+  return !SameDomainOrHost(
+      url,
+      url::Origin::CreateFromNormalizedTuple("https", tab_host.c_str(), 80),
+      INCLUDE_PRIVATE_REGISTRIES);
+}
+
+}  // namespace
+
+namespace brave_shields {
+
+AdBlockEngineSnapshot::AdBlockEngineSnapshot(
+    std::unique_ptr<adblock::Engine> engine,
+    scoped_refptr<base::SequencedTaskRunner> owning_task_runner)
+    : base::RefCountedDeleteOnSequence<AdBlockEngineSnapshot>(
+          std::move(owning_task_runner)),
+      engine_(std::move(engine)) {
+  DCHECK(engine_);
+}
+
+AdBlockEngineSnapshot::~AdBlockEngineSnapshot() = default;
+
+void AdBlockEngineSnapshot::ShouldStartRequest(
+    const GURL& url,
+    blink::mojom::ResourceType resource_type,
+    const std::string& tab_host,
+    bool* did_match_rule,
+    bool* did_match_exception,
+    bool* did_match_important,
+    std::string* mock_data_url) const {
+  const bool is_third_party = IsThirdParty(url, tab_host);
+  engine_->matches(
+      url.spec(), url.host(), tab_host, is_third_party,
+      ResourceTypeToString(resource_type), did_match_rule,
+      did_match_exception, did_match_important, mock_data_url);
+}
+
+// static
+int AdBlockEngineSnapshot::MatchEngines(
+    const std::vector<scoped_refptr<AdBlockEngineSnapshot>>& engines,
+    const GURL& url,
+    blink::mojom::ResourceType resource_type,
+    const std::string& tab_host,
+    bool* did_match_rule,
+    bool* did_match_exception,
+    bool* did_match_important,
+    std::string* mock_data_url) {
+  std::vector<const adblock::Engine*> raw_engines;
+  raw_engines.reserve(engines.size());
+  for (const auto& engine : engines) {
+    raw_engines.push_back(engine->engine_.get());
+  }
+
+  int matched_engine = -1;
+  adblock::Engine::matchesAll(
+      raw_engines, url.spec(), url.host(), tab_host,
+      IsThirdParty(url, tab_host), ResourceTypeToString(resource_type),
+      did_match_rule, did_match_exception, did_match_important,
+      &matched_engine, mock_data_url);
+  return matched_engine;
+}
+
+base::Optional<std::string> AdBlockEngineSnapshot::GetCspDirectives(
+    const GURL& url,
+    blink::mojom::ResourceType resource_type,
+    const std::string& tab_host) const {
+  const bool is_third_party = IsThirdParty(url, tab_host);
+  const std::string result = engine_->getCspDirectives(
+      url.spec(), url.host(), tab_host, is_third_party,
+      ResourceTypeToString(resource_type));
+
+  if (result.empty()) {
+    return base::nullopt;
+  } else {
+    return base::Optional<std::string>(result);
+  }
+}
+
+base::Optional<base::Value> AdBlockEngineSnapshot::UrlCosmeticResources(
+    const std::string& url) const {
+  return base::JSONReader::Read(engine_->urlCosmeticResources(url));
+}
+
+base::Optional<base::Value> AdBlockEngineSnapshot::HiddenClassIdSelectors(
+    const std::vector<std::string>& classes,
+    const std::vector<std::string>& ids,
+    const std::vector<std::string>& exceptions) const {
+  return base::JSONReader::Read(
+      engine_->hiddenClassIdSelectors(classes, ids, exceptions));
+}
+
+}  // namespace brave_shields
@@ -0,0 +1,82 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_ENGINE_SNAPSHOT_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_ENGINE_SNAPSHOT_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/ref_counted_delete_on_sequence.h"
+#include "base/optional.h"
+#include "base/sequenced_task_runner.h"
+#include "base/values.h"
+#include "third_party/blink/public/mojom/loader/resource_load_info.mojom-shared.h"
+#include "url/gurl.h"
+
+namespace adblock {
+class Engine;
+}
+
+namespace brave_shields {
+
+// An ad-block engine which is never modified once it has been published, so
+// it can be queried from any thread without holding a lock. Tag, resource and
+// filter list changes build a new snapshot instead. The engine is destroyed
+// on |owning_task_runner|, as tearing down a large engine is slow.
+class AdBlockEngineSnapshot
+    : public base::RefCountedDeleteOnSequence<AdBlockEngineSnapshot> {
+ public:
+  AdBlockEngineSnapshot(
+      std::unique_ptr<adblock::Engine> engine,
+      scoped_refptr<base::SequencedTaskRunner> owning_task_runner);
+
+  void ShouldStartRequest(const GURL& url,
+                          blink::mojom::ResourceType resource_type,
+                          const std::string& tab_host,
+                          bool* did_match_rule,
+                          bool* did_match_exception,
+                          bool* did_match_important,
+                          std::string* mock_data_url) const;
+  // Checks a request against each of |engines| in order with a single call
+  // into the library, stopping once an important rule matches. Returns the
+  // index of the last engine that matched a rule, exception or important
+  // rule, or -1 if none did.
+  static int MatchEngines(
+      const std::vector<scoped_refptr<AdBlockEngineSnapshot>>& engines,
+      const GURL& url,
+      blink::mojom::ResourceType resource_type,
+      const std::string& tab_host,
+      bool* did_match_rule,
+      bool* did_match_exception,
+      bool* did_match_important,
+      std::string* mock_data_url);
+
+  base::Optional<std::string> GetCspDirectives(
+      const GURL& url,
+      blink::mojom::ResourceType resource_type,
+      const std::string& tab_host) const;
+  base::Optional<base::Value> UrlCosmeticResources(
+      const std::string& url) const;
+  base::Optional<base::Value> HiddenClassIdSelectors(
+      const std::vector<std::string>& classes,
+      const std::vector<std::string>& ids,
+      const std::vector<std::string>& exceptions) const;
+
+ private:
+  friend class base::RefCountedDeleteOnSequence<AdBlockEngineSnapshot>;
+  friend class base::DeleteHelper<AdBlockEngineSnapshot>;
+  ~AdBlockEngineSnapshot();
+
+  const std::unique_ptr<adblock::Engine> engine_;
+
+  DISALLOW_COPY_AND_ASSIGN(AdBlockEngineSnapshot);
+};
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_ENGINE_SNAPSHOT_H_
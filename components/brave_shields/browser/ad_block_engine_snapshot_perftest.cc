@@ -0,0 +1,239 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/atomic_flag.h"
+#include "base/synchronization/lock.h"
+#include "base/test/task_environment.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "brave/components/adblock_rust_ffi/src/wrapper.h"
+#include "brave/components/brave_shields/browser/ad_block_engine_snapshot.h"
+#include "brave/components/brave_shields/browser/ad_block_service_helper.h"
+#include "brave/components/brave_shields/common/brave_shield_constants.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+// npm run test -- brave_unit_tests --filter=AdBlockEngineSnapshotPerfTest.*
+// --gtest_also_run_disabled_tests
+
+namespace brave_shields {
+
+namespace {
+
+const char kMetricSingleSequence[] = ".single_sequence";
+const char kMetricSnapshots[] = ".snapshots";
+const char kMetricRebuild[] = ".rebuild";
+const char kMetricRetainedInput[] = ".retained_input";
+
+const int kRuleCount = 5000;
+const int kMatchesPerThread = 20000;
+const int kRebuilds = 20;
+
+std::string BuildRules() {
+  std::string rules;
+  for (int i = 0; i < kRuleCount; i++) {
+    rules += base::StringPrintf("||ads%d.example.com^\n", i);
+    rules += base::StringPrintf("/banner%d/*$image\n", i);
+  }
+  return rules;
+}
+
+// Publishes engine snapshots the same way as AdBlockBaseService
+class EngineHolder {
+ public:
+  EngineHolder() = default;
+
+  scoped_refptr<AdBlockEngineSnapshot> Get() const {
+    base::AutoLock lock(lock_);
+    return engine_;
+  }
+
+  void Publish(scoped_refptr<AdBlockEngineSnapshot> engine) {
+    base::AutoLock lock(lock_);
+    engine_.swap(engine);
+  }
+
+ private:
+  mutable base::Lock lock_;
+  scoped_refptr<AdBlockEngineSnapshot> engine_;
+};
+
+class Reader : public base::DelegateSimpleThread::Delegate {
+ public:
+  // Every match holds |sequence_lock| when it is set, which is how requests
+  // were checked when they all ran on the ad-block service's task runner
+  Reader(const EngineHolder* holder, base::Lock* sequence_lock)
+      : holder_(holder), sequence_lock_(sequence_lock) {}
+
+  void Run() override {
+    for (int i = 0; i < kMatchesPerThread; i++) {
+      const GURL url(base::StringPrintf(
+          "https://ads%d.example.com/banner%d/image.png", i % (2 * kRuleCount),
+          i % kRuleCount));
+      bool did_match_rule = false;
+      bool did_match_exception = false;
+      bool did_match_important = false;
+      std::string mock_data_url;
+
+      if (sequence_lock_) {
+        base::AutoLock lock(*sequence_lock_);
+        Match(url, &did_match_rule, &did_match_exception,
+              &did_match_important, &mock_data_url);
+      } else {
+        Match(url, &did_match_rule, &did_match_exception,
+              &did_match_important, &mock_data_url);
+      }
+    }
+  }
+
+ private:
+  void Match(const GURL& url,
+             bool* did_match_rule,
+             bool* did_match_exception,
+             bool* did_match_important,
+             std::string* mock_data_url) {
+    holder_->Get()->ShouldStartRequest(
+        url, blink::mojom::ResourceType::kImage, "brave.com", did_match_rule,
+        did_match_exception, did_match_important, mock_data_url);
+  }
+
+  const EngineHolder* holder_;  // NOT OWNED
+  base::Lock* sequence_lock_;  // NOT OWNED
+};
+
+// Keeps building and publishing new snapshots until |done| is set
+class Writer : public base::DelegateSimpleThread::Delegate {
+ public:
+  Writer(EngineHolder* holder,
+         const std::string& rules,
+         scoped_refptr<base::SequencedTaskRunner> task_runner,
+         const base::AtomicFlag* done)
+      : holder_(holder),
+        rules_(rules),
+        task_runner_(std::move(task_runner)),
+        done_(done) {}
+
+  void Run() override {
+    while (!done_->IsSet()) {
+      holder_->Publish(base::MakeRefCounted<AdBlockEngineSnapshot>(
+          std::make_unique<adblock::Engine>(rules_), task_runner_));
+    }
+  }
+
+ private:
+  EngineHolder* holder_;  // NOT OWNED
+  const std::string& rules_;
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+  const base::AtomicFlag* done_;  // NOT OWNED
+};
+
+}  // namespace
+
+class AdBlockEngineSnapshotPerfTest : public testing::Test {
+ protected:
+  AdBlockEngineSnapshotPerfTest() : rules_(BuildRules()) {
+    adblock::SetDomainResolver(AdBlockServiceDomainResolver);
+  }
+
+  // Returns the time taken for |reader_count| threads to each match
+  // |kMatchesPerThread| requests while a new engine is repeatedly published
+  base::TimeDelta MatchConcurrently(int reader_count, bool single_sequence) {
+    EngineHolder holder;
+    holder.Publish(base::MakeRefCounted<AdBlockEngineSnapshot>(
+        std::make_unique<adblock::Engine>(rules_),
+        base::SequencedTaskRunnerHandle::Get()));
+
+    base::AtomicFlag done;
+    Writer writer(&holder, rules_, base::SequencedTaskRunnerHandle::Get(),
+                  &done);
+    base::DelegateSimpleThread writer_thread(&writer, "writer");
+
+    base::Lock sequence_lock;
+    std::vector<std::unique_ptr<Reader>> readers;
+    std::vector<std::unique_ptr<base::DelegateSimpleThread>> reader_threads;
+    for (int i = 0; i < reader_count; i++) {
+      readers.push_back(std::make_unique<Reader>(
+          &holder, single_sequence ? &sequence_lock : nullptr));
+      reader_threads.push_back(std::make_unique<base::DelegateSimpleThread>(
+          readers.back().get(), base::StringPrintf("reader%d", i)));
+    }
+
+    writer_thread.Start();
+    const base::TimeTicks start = base::TimeTicks::Now();
+    for (auto& reader_thread : reader_threads) {
+      reader_thread->Start();
+    }
+    for (auto& reader_thread : reader_threads) {
+      reader_thread->Join();
+    }
+    const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    done.Set();
+    writer_thread.Join();
+    task_environment_.RunUntilIdle();
+
+    return elapsed;
+  }
+
+  void RunStory(int reader_count) {
+    perf_test::PerfResultReporter reporter(
+        "AdBlockEngineSnapshot.",
+        base::StringPrintf("%d_threads", reader_count));
+    reporter.RegisterImportantMetric(kMetricSingleSequence, "ms");
+    reporter.RegisterImportantMetric(kMetricSnapshots, "ms");
+    reporter.AddResult(kMetricSingleSequence,
+                       MatchConcurrently(reader_count, true));
+    reporter.AddResult(kMetricSnapshots,
+                       MatchConcurrently(reader_count, false));
+  }
+
+  // Returns the average time taken to build an engine the way
+  // AdBlockBaseService does whenever a tag or resources change
+  base::TimeDelta RebuildEngine() {
+    base::TimeDelta elapsed;
+    for (int i = 0; i < kRebuilds; i++) {
+      const base::TimeTicks start = base::TimeTicks::Now();
+      auto engine = std::make_unique<adblock::Engine>(rules_);
+      engine->addTag(kTwitterEmbeds);
+      engine->addResources("[]");
+      elapsed += base::TimeTicks::Now() - start;
+    }
+    return elapsed / kRebuilds;
+  }
+
+  base::test::TaskEnvironment task_environment_;
+  const std::string rules_;
+};
+
+TEST_F(AdBlockEngineSnapshotPerfTest, DISABLED_OneThread) {
+  RunStory(1);
+}
+
+TEST_F(AdBlockEngineSnapshotPerfTest, DISABLED_FourThreads) {
+  RunStory(4);
+}
+
+TEST_F(AdBlockEngineSnapshotPerfTest, DISABLED_EightThreads) {
+  RunStory(8);
+}
+
+TEST_F(AdBlockEngineSnapshotPerfTest, DISABLED_Rebuild) {
+  perf_test::PerfResultReporter reporter(
+      "AdBlockEngineSnapshot.", base::StringPrintf("%d_rules", 2 * kRuleCount));
+  reporter.RegisterImportantMetric(kMetricRebuild, "ms");
+  reporter.RegisterImportantMetric(kMetricRetainedInput, "bytes");
+  reporter.AddResult(kMetricRebuild, RebuildEngine());
+  reporter.AddResult(kMetricRetainedInput, rules_.size());
+}
+
+}  // namespace brave_shields
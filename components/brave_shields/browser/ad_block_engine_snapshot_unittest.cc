@@ -0,0 +1,155 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/ad_block_engine_snapshot.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/test/task_environment.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "brave/components/adblock_rust_ffi/src/wrapper.h"
+#include "brave/components/brave_shields/browser/ad_block_service_helper.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+// npm run test -- brave_unit_tests --filter=AdBlockEngineSnapshotTest.*
+
+namespace brave_shields {
+
+namespace {
+
+struct MatchResult {
+  bool did_match_rule = false;
+  bool did_match_exception = false;
+  bool did_match_important = false;
+  std::string mock_data_url;
+  int matched_engine = -1;
+};
+
+}  // namespace
+
+class AdBlockEngineSnapshotTest : public testing::Test {
+ protected:
+  AdBlockEngineSnapshotTest() {
+    adblock::SetDomainResolver(AdBlockServiceDomainResolver);
+  }
+
+  void AddEngine(const std::string& rules) {
+    engines_.push_back(base::MakeRefCounted<AdBlockEngineSnapshot>(
+        std::make_unique<adblock::Engine>(rules),
+        base::SequencedTaskRunnerHandle::Get()));
+  }
+
+  MatchResult MatchEngines(const std::string& url) {
+    MatchResult result;
+    result.matched_engine = AdBlockEngineSnapshot::MatchEngines(
+        engines_, GURL(url), blink::mojom::ResourceType::kScript,
+        "brave.com", &result.did_match_rule, &result.did_match_exception,
+        &result.did_match_important, &result.mock_data_url);
+    return result;
+  }
+
+  // Queries each engine separately, the way requests used to be checked
+  MatchResult MatchEachEngine(const std::string& url) {
+    MatchResult result;
+    for (const auto& engine : engines_) {
+      engine->ShouldStartRequest(
+          GURL(url), blink::mojom::ResourceType::kScript, "brave.com",
+          &result.did_match_rule, &result.did_match_exception,
+          &result.did_match_important, &result.mock_data_url);
+      if (result.did_match_important) {
+        break;
+      }
+    }
+    return result;
+  }
+
+  void ExpectSameAsEachEngine(const std::string& url,
+                              const MatchResult& result) {
+    const MatchResult expected = MatchEachEngine(url);
+    EXPECT_EQ(expected.did_match_rule, result.did_match_rule) << url;
+    EXPECT_EQ(expected.did_match_exception, result.did_match_exception)
+        << url;
+    EXPECT_EQ(expected.did_match_important, result.did_match_important)
+        << url;
+    EXPECT_EQ(expected.mock_data_url, result.mock_data_url) << url;
+  }
+
+  base::test::TaskEnvironment task_environment_;
+  std::vector<scoped_refptr<AdBlockEngineSnapshot>> engines_;
+};
+
+TEST_F(AdBlockEngineSnapshotTest, NoEngines) {
+  const MatchResult result = MatchEngines("https://ads.example.com/ad.js");
+
+  EXPECT_FALSE(result.did_match_rule);
+  EXPECT_EQ(-1, result.matched_engine);
+}
+
+TEST_F(AdBlockEngineSnapshotTest, NoMatch) {
+  AddEngine("||ads.example.com^");
+  AddEngine("||tracker.example.com^");
+
+  const std::string url = "https://example.com/script.js";
+  const MatchResult result = MatchEngines(url);
+
+  EXPECT_FALSE(result.did_match_rule);
+  EXPECT_EQ(-1, result.matched_engine);
+  ExpectSameAsEachEngine(url, result);
+}
+
+TEST_F(AdBlockEngineSnapshotTest, ReportsMatchingEngine) {
+  AddEngine("||ads.example.com^");
+  AddEngine("||tracker.example.com^");
+  AddEngine("||custom.example.com^");
+
+  std::string url = "https://tracker.example.com/script.js";
+  MatchResult result = MatchEngines(url);
+  EXPECT_TRUE(result.did_match_rule);
+  EXPECT_EQ(1, result.matched_engine);
+  ExpectSameAsEachEngine(url, result);
+
+  url = "https://custom.example.com/script.js";
+  result = MatchEngines(url);
+  EXPECT_TRUE(result.did_match_rule);
+  EXPECT_EQ(2, result.matched_engine);
+  ExpectSameAsEachEngine(url, result);
+}
+
+TEST_F(AdBlockEngineSnapshotTest, ExceptionInLaterEngine) {
+  AddEngine("||ads.example.com^");
+  AddEngine("@@||ads.example.com/allowed.js");
+
+  std::string url = "https://ads.example.com/allowed.js";
+  MatchResult result = MatchEngines(url);
+  EXPECT_TRUE(result.did_match_rule);
+  EXPECT_TRUE(result.did_match_exception);
+  EXPECT_EQ(1, result.matched_engine);
+  ExpectSameAsEachEngine(url, result);
+
+  url = "https://ads.example.com/blocked.js";
+  result = MatchEngines(url);
+  EXPECT_TRUE(result.did_match_rule);
+  EXPECT_FALSE(result.did_match_exception);
+  EXPECT_EQ(0, result.matched_engine);
+  ExpectSameAsEachEngine(url, result);
+}
+
+TEST_F(AdBlockEngineSnapshotTest, ImportantStopsLaterEngines) {
+  AddEngine("||ads.example.com^$important");
+  AddEngine("@@||ads.example.com^");
+
+  const std::string url = "https://ads.example.com/ad.js";
+  const MatchResult result = MatchEngines(url);
+
+  EXPECT_TRUE(result.did_match_important);
+  EXPECT_FALSE(result.did_match_exception);
+  EXPECT_EQ(0, result.matched_engine);
+  ExpectSameAsEachEngine(url, result);
+}
+
+}  // namespace brave_shields
@@ -0,0 +1,49 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/ad_block_match_cache.h"
+
+namespace brave_shields {
+
+AdBlockMatchCache::AdBlockMatchCache(size_t max_size) : entries_(max_size) {
+  DETACH_FROM_SEQUENCE(sequence_checker_);
+}
+
+AdBlockMatchCache::~AdBlockMatchCache() = default;
+
+bool AdBlockMatchCache::Get(const GURL& url,
+                            const std::string& tab_host,
+                            blink::mojom::ResourceType resource_type,
+                            uint64_t engine_generation,
+                            Result* result) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  DCHECK(result);
+
+  auto it = entries_.Get(Key(url.spec(), tab_host, resource_type));
+  if (it == entries_.end()) {
+    return false;
+  }
+
+  // Filter lists, tags or resources changed since the result was stored
+  if (it->second.engine_generation != engine_generation) {
+    entries_.Erase(it);
+    return false;
+  }
+
+  *result = it->second.result;
+  return true;
+}
+
+void AdBlockMatchCache::Put(const GURL& url,
+                            const std::string& tab_host,
+                            blink::mojom::ResourceType resource_type,
+                            uint64_t engine_generation,
+                            const Result& result) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  entries_.Put(Key(url.spec(), tab_host, resource_type),
+               Entry{engine_generation, result});
+}
+
+}  // namespace brave_shields
@@ -0,0 +1,77 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_MATCH_CACHE_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_MATCH_CACHE_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <tuple>
+
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "base/sequence_checker.h"
+#include "base/time/time.h"
+#include "third_party/blink/public/mojom/loader/resource_load_info.mojom-shared.h"
+#include "url/gurl.h"
+
+namespace brave_shields {
+
+// Defined in ad_block_service.h, which depends on this header
+enum class AdBlockFilterListSource;
+
+// Remembers the results of recent network request checks, so that requests a
+// page repeats (beacons, polling XHRs, the same pixel in several frames) don't
+// query the engines again. Results are only returned for the engine
+// generation they were stored with. The cache is only used on the sequence
+// which dispatches requests, so it needs no locking.
+class AdBlockMatchCache {
+ public:
+  struct Result {
+    bool did_match_rule = false;
+    bool did_match_exception = false;
+    bool did_match_important = false;
+    std::string mock_data_url;
+    // The filter list which decided the outcome, so that cache hits can still
+    // be attributed to a list. Value-initialized to kNone
+    AdBlockFilterListSource matched_list{};
+    // How long the engine query took, which a cache hit saves
+    base::TimeDelta query_time;
+  };
+
+  explicit AdBlockMatchCache(size_t max_size = 1000);
+  ~AdBlockMatchCache();
+
+  bool Get(const GURL& url,
+           const std::string& tab_host,
+           blink::mojom::ResourceType resource_type,
+           uint64_t engine_generation,
+           Result* result);
+  void Put(const GURL& url,
+           const std::string& tab_host,
+           blink::mojom::ResourceType resource_type,
+           uint64_t engine_generation,
+           const Result& result);
+
+ private:
+  using Key =
+      std::tuple<std::string, std::string, blink::mojom::ResourceType>;
+
+  struct Entry {
+    uint64_t engine_generation;
+    Result result;
+  };
+
+  base::MRUCache<Key, Entry> entries_;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  DISALLOW_COPY_AND_ASSIGN(AdBlockMatchCache);
+};
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_MATCH_CACHE_H_
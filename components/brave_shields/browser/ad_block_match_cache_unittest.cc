@@ -0,0 +1,94 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/ad_block_match_cache.h"
+
+#include "brave/components/brave_shields/browser/ad_block_service.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+// npm run test -- brave_unit_tests --filter=AdBlockMatchCacheTest.*
+
+namespace brave_shields {
+
+namespace {
+
+const GURL kPixelUrl("https://tracker.example.com/pixel.gif");
+
+AdBlockMatchCache::Result BlockedResult() {
+  AdBlockMatchCache::Result result;
+  result.did_match_rule = true;
+  result.mock_data_url = "data:image/gif;base64,R0lGODlhAQABAAAAACw=";
+  result.matched_list = AdBlockFilterListSource::kRegional;
+  result.query_time = base::TimeDelta::FromMicroseconds(150);
+  return result;
+}
+
+}  // namespace
+
+TEST(AdBlockMatchCacheTest, GetStoredResult) {
+  AdBlockMatchCache cache;
+  cache.Put(kPixelUrl, "brave.com", blink::mojom::ResourceType::kImage, 1,
+            BlockedResult());
+
+  AdBlockMatchCache::Result result;
+  ASSERT_TRUE(cache.Get(kPixelUrl, "brave.com",
+                        blink::mojom::ResourceType::kImage, 1, &result));
+  EXPECT_TRUE(result.did_match_rule);
+  EXPECT_FALSE(result.did_match_exception);
+  EXPECT_FALSE(result.did_match_important);
+  EXPECT_EQ(BlockedResult().mock_data_url, result.mock_data_url);
+  EXPECT_EQ(AdBlockFilterListSource::kRegional, result.matched_list);
+  EXPECT_EQ(BlockedResult().query_time, result.query_time);
+}
+
+TEST(AdBlockMatchCacheTest, KeyedByTabHostAndResourceType) {
+  AdBlockMatchCache cache;
+  cache.Put(kPixelUrl, "brave.com", blink::mojom::ResourceType::kImage, 1,
+            BlockedResult());
+
+  AdBlockMatchCache::Result result;
+  EXPECT_FALSE(cache.Get(kPixelUrl, "example.com",
+                         blink::mojom::ResourceType::kImage, 1, &result));
+  EXPECT_FALSE(cache.Get(kPixelUrl, "brave.com",
+                         blink::mojom::ResourceType::kScript, 1, &result));
+  EXPECT_FALSE(cache.Get(GURL("https://tracker.example.com/other.gif"),
+                         "brave.com", blink::mojom::ResourceType::kImage, 1,
+                         &result));
+}
+
+TEST(AdBlockMatchCacheTest, NewEngineGenerationInvalidates) {
+  AdBlockMatchCache cache;
+  cache.Put(kPixelUrl, "brave.com", blink::mojom::ResourceType::kImage, 1,
+            BlockedResult());
+
+  AdBlockMatchCache::Result result;
+  EXPECT_FALSE(cache.Get(kPixelUrl, "brave.com",
+                         blink::mojom::ResourceType::kImage, 2, &result));
+  // The stale entry was dropped
+  EXPECT_FALSE(cache.Get(kPixelUrl, "brave.com",
+                         blink::mojom::ResourceType::kImage, 1, &result));
+}
+
+TEST(AdBlockMatchCacheTest, EvictsLeastRecentlyUsed) {
+  AdBlockMatchCache cache(2);
+  const GURL a("https://a.example.com/");
+  const GURL b("https://b.example.com/");
+  const GURL c("https://c.example.com/");
+  const auto type = blink::mojom::ResourceType::kXhr;
+
+  cache.Put(a, "brave.com", type, 1, BlockedResult());
+  cache.Put(b, "brave.com", type, 1, BlockedResult());
+
+  AdBlockMatchCache::Result result;
+  ASSERT_TRUE(cache.Get(a, "brave.com", type, 1, &result));
+
+  // |a| was just used, so |b| is evicted
+  cache.Put(c, "brave.com", type, 1, BlockedResult());
+  EXPECT_TRUE(cache.Get(a, "brave.com", type, 1, &result));
+  EXPECT_FALSE(cache.Get(b, "brave.com", type, 1, &result));
+  EXPECT_TRUE(cache.Get(c, "brave.com", type, 1, &result));
+}
+
+}  // namespace brave_shields
@@ -13,6 +13,7 @@
 #include "base/task/post_task.h"
 #include "base/values.h"
 #include "brave/components/adblock_rust_ffi/src/wrapper.h"
+#include "brave/components/brave_shields/browser/ad_block_base_service.h"
 #include "brave/components/brave_shields/browser/ad_block_regional_service.h"
 #include "brave/components/brave_shields/browser/ad_block_service.h"
 #include "brave/components/brave_shields/browser/ad_block_service_helper.h"
@@ -115,35 +116,15 @@ bool AdBlockRegionalServiceManager::Start() {
   return true;
 }
 
-void AdBlockRegionalServiceManager::ShouldStartRequest(
-    const GURL& url,
-    blink::mojom::ResourceType resource_type,
-    const std::string& tab_host,
-    bool* did_match_rule,
-    bool* did_match_exception,
-    bool* did_match_important,
-    std::string* mock_data_url) {
-  base::AutoLock lock(regional_services_lock_);
-
-  for (const auto& regional_service : regional_services_) {
-    regional_service.second->ShouldStartRequest(
-        url, resource_type, tab_host, did_match_rule, did_match_exception,
-        did_match_important, mock_data_url);
-    if (did_match_important && *did_match_important) {
-      return;
-    }
-  }
-}
-
 base::Optional<std::string> AdBlockRegionalServiceManager::GetCspDirectives(
     const GURL& url,
     blink::mojom::ResourceType resource_type,
     const std::string& tab_host) {
   base::Optional<std::string> csp_directives = base::nullopt;
 
-  for (const auto& regional_service : regional_services_) {
+  for (const auto& engine : GetRegionalEngines()) {
     const auto directive =
-        regional_service.second->GetCspDirectives(url, resource_type, tab_host);
+        engine->GetCspDirectives(url, resource_type, tab_host);
     MergeCspDirectiveInto(directive, &csp_directives);
   }
 
@@ -191,6 +172,9 @@ void AdBlockRegionalServiceManager::EnableFilterList(
       it->second->Unregister();
       regional_services_.erase(it);
     }
+    // Results may have been matched against the removed list, or stored
+    // without the added one
+    AdBlockBaseService::InvalidateEngineGeneration();
   }
 
   // Update preferences to reflect enabled/disabled state of specified
@@ -204,17 +188,17 @@ void AdBlockRegionalServiceManager::EnableFilterList(
 base::Optional<base::Value>
 AdBlockRegionalServiceManager::UrlCosmeticResources(
         const std::string& url) {
-  base::AutoLock lock(regional_services_lock_);
-  auto it = regional_services_.begin();
-  if (it == regional_services_.end()) {
+  const auto engines = GetRegionalEngines();
+  auto it = engines.begin();
+  if (it == engines.end()) {
     return base::Optional<base::Value>();
   }
   base::Optional<base::Value> first_value =
-      it->second->UrlCosmeticResources(url);
+      (*it)->UrlCosmeticResources(url);
 
-  for ( ; it != regional_services_.end(); it++) {
+  for ( ; it != engines.end(); it++) {
     base::Optional<base::Value> next_value =
-        it->second->UrlCosmeticResources(url);
+        (*it)->UrlCosmeticResources(url);
     if (first_value) {
       if (next_value) {
         MergeResourcesInto(std::move(*next_value), &*first_value, false);
@@ -232,17 +216,17 @@ AdBlockRegionalServiceManager::HiddenClassIdSelectors(
         const std::vector<std::string>& classes,
         const std::vector<std::string>& ids,
         const std::vector<std::string>& exceptions) {
-  base::AutoLock lock(regional_services_lock_);
-  auto it = regional_services_.begin();
-  if (it == regional_services_.end()) {
+  const auto engines = GetRegionalEngines();
+  auto it = engines.begin();
+  if (it == engines.end()) {
     return base::Optional<base::Value>();
   }
   base::Optional<base::Value> first_value =
-      it->second->HiddenClassIdSelectors(classes, ids, exceptions);
+      (*it)->HiddenClassIdSelectors(classes, ids, exceptions);
 
-  for ( ; it != regional_services_.end(); it++) {
+  for ( ; it != engines.end(); it++) {
     base::Optional<base::Value> next_value =
-        it->second->HiddenClassIdSelectors(classes, ids, exceptions);
+        (*it)->HiddenClassIdSelectors(classes, ids, exceptions);
     if (first_value && first_value->is_list()) {
       if (next_value && next_value->is_list()) {
         for (auto i = next_value->GetList().begin();
@@ -259,6 +243,17 @@ AdBlockRegionalServiceManager::HiddenClassIdSelectors(
   return first_value;
 }
 
+std::vector<scoped_refptr<AdBlockEngineSnapshot>>
+AdBlockRegionalServiceManager::GetRegionalEngines() {
+  std::vector<scoped_refptr<AdBlockEngineSnapshot>> engines;
+  base::AutoLock lock(regional_services_lock_);
+  engines.reserve(regional_services_.size());
+  for (const auto& regional_service : regional_services_) {
+    engines.push_back(regional_service.second->GetEngine());
+  }
+  return engines;
+}
+
 void AdBlockRegionalServiceManager::SetRegionalCatalog(
         std::vector<adblock::FilterList> catalog) {
   regional_catalog_ = std::move(catalog);
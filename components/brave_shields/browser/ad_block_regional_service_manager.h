@@ -18,6 +18,7 @@
 #include "base/values.h"
 #include "brave/components/adblock_rust_ffi/src/wrapper.h"
 #include "brave/components/brave_component_updater/browser/brave_component.h"
+#include "brave/components/brave_shields/browser/ad_block_engine_snapshot.h"
 #include "third_party/blink/public/mojom/loader/resource_load_info.mojom-shared.h"
 #include "url/gurl.h"
 
@@ -47,13 +48,6 @@ class AdBlockRegionalServiceManager {
 
   bool IsInitialized() const;
   bool Start();
-  void ShouldStartRequest(const GURL& url,
-                          blink::mojom::ResourceType resource_type,
-                          const std::string& tab_host,
-                          bool* did_match_rule,
-                          bool* did_match_exception,
-                          bool* did_match_important,
-                          std::string* mock_data_url);
   base::Optional<std::string> GetCspDirectives(
       const GURL& url,
       blink::mojom::ResourceType resource_type,
@@ -69,6 +63,10 @@ class AdBlockRegionalServiceManager {
           const std::vector<std::string>& ids,
           const std::vector<std::string>& exceptions);
 
+  // Copies the current engine of every regional service, so that requests can
+  // be matched without holding |regional_services_lock_|
+  std::vector<scoped_refptr<AdBlockEngineSnapshot>> GetRegionalEngines();
+
  private:
   friend class ::AdBlockServiceTest;
   void StartRegionalServices();
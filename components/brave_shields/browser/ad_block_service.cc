@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "base/base_paths.h"
 #include "base/bind.h"
@@ -28,36 +29,12 @@
 #include "components/prefs/pref_change_registrar.h"
 #include "components/prefs/pref_registry_simple.h"
 #include "components/prefs/pref_service.h"
-#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
 
 #define DAT_FILE "rs-ABPFilterParserData.dat"
 #define REGIONAL_CATALOG "regional_catalog.json"
 
 namespace brave_shields {
 
-namespace {
-
-// Extracts the start and end characters of a domain from a hostname.
-// Required for correct functionality of adblock-rust.
-void AdBlockServiceDomainResolver(const char* host,
-                                  uint32_t* start,
-                                  uint32_t* end) {
-  const auto host_str = std::string(host);
-  const auto domain = net::registry_controlled_domains::GetDomainAndRegistry(
-      host_str,
-      net::registry_controlled_domains::INCLUDE_PRIVATE_REGISTRIES);
-  const size_t match = host_str.rfind(domain);
-  if (match != std::string::npos) {
-    *start = match;
-    *end = match + domain.length();
-  } else {
-    *start = 0;
-    *end = host_str.length();
-  }
-}
-
-}  // namespace
-
 std::string AdBlockService::g_ad_block_component_id_(kAdBlockComponentId);
 std::string AdBlockService::g_ad_block_component_base64_public_key_(
     kAdBlockComponentBase64PublicKey);
@@ -70,23 +47,44 @@ void AdBlockService::ShouldStartRequest(
     bool* did_match_exception,
     bool* did_match_important,
     std::string* mock_data_url) {
-  AdBlockBaseService::ShouldStartRequest(
-      url, resource_type, tab_host, did_match_rule, did_match_exception,
-      did_match_important, mock_data_url);
-  if (did_match_important && *did_match_important) {
-    return;
-  }
+  ShouldStartRequest(url, resource_type, tab_host, did_match_rule,
+                     did_match_exception, did_match_important, mock_data_url,
+                     nullptr);
+}
 
-  regional_service_manager()->ShouldStartRequest(
-      url, resource_type, tab_host, did_match_rule, did_match_exception,
-      did_match_important, mock_data_url);
-  if (did_match_important && *did_match_important) {
+void AdBlockService::ShouldStartRequest(
+    const GURL& url,
+    blink::mojom::ResourceType resource_type,
+    const std::string& tab_host,
+    bool* did_match_rule,
+    bool* did_match_exception,
+    bool* did_match_important,
+    std::string* mock_data_url,
+    AdBlockFilterListSource* matched_list) {
+  // The lists are checked in the same order as they were when each was
+  // queried separately: default, then regional, then custom filters
+  std::vector<scoped_refptr<AdBlockEngineSnapshot>> engines =
+      regional_service_manager()->GetRegionalEngines();
+  const int regional_count = static_cast<int>(engines.size());
+  engines.insert(engines.begin(), GetEngine());
+  engines.push_back(custom_filters_service()->GetEngine());
+
+  const int matched_engine = AdBlockEngineSnapshot::MatchEngines(
+      engines, url, resource_type, tab_host, did_match_rule,
+      did_match_exception, did_match_important, mock_data_url);
+
+  if (!matched_list) {
     return;
   }
-
-  custom_filters_service()->ShouldStartRequest(
-      url, resource_type, tab_host, did_match_rule, did_match_exception,
-      did_match_important, mock_data_url);
+  if (matched_engine < 0) {
+    *matched_list = AdBlockFilterListSource::kNone;
+  } else if (matched_engine == 0) {
+    *matched_list = AdBlockFilterListSource::kDefault;
+  } else if (matched_engine <= regional_count) {
+    *matched_list = AdBlockFilterListSource::kRegional;
+  } else {
+    *matched_list = AdBlockFilterListSource::kCustom;
+  }
 }
 
 base::Optional<std::string> AdBlockService::GetCspDirectives(
@@ -201,6 +199,10 @@ AdBlockService::custom_filters_service() {
   return custom_filters_service_.get();
 }
 
+AdBlockMatchCache* AdBlockService::match_cache() {
+  return &match_cache_;
+}
+
 AdBlockService::AdBlockService(
     brave_component_updater::BraveComponent::Delegate* delegate)
     : AdBlockBaseService(delegate), component_delegate_(delegate) {}
@@ -15,6 +15,7 @@
 #include "base/optional.h"
 #include "base/values.h"
 #include "brave/components/brave_shields/browser/ad_block_base_service.h"
+#include "brave/components/brave_shields/browser/ad_block_match_cache.h"
 #include "components/keyed_service/core/keyed_service.h"
 #include "components/prefs/pref_registry_simple.h"
 #include "content/public/browser/browser_thread.h"
@@ -43,6 +44,16 @@ const char kAdBlockComponentBase64PublicKey[] =
     "5HcH/heRrB4MvrE1J76WF3fvZ03aHVcnlLtQeiNNOZ7VbBDXdie8Nomf/QswbBGa"
     "VwIDAQAB";
 
+// The filter list whose rule decided the outcome of a network request check.
+// Note: append-only enumeration, as it is used to bucket a UMA histogram.
+enum class AdBlockFilterListSource {
+  kNone,
+  kDefault,
+  kRegional,
+  kCustom,
+  kMaxValue = kCustom,
+};
+
 // The brave shields service in charge of ad-block checking and init.
 class AdBlockService : public AdBlockBaseService {
  public:
@@ -56,6 +67,16 @@ class AdBlockService : public AdBlockBaseService {
                           bool* did_match_exception,
                           bool* did_match_important,
                           std::string* mock_data_url) override;
+  // Checks the request against the default, regional and custom filter lists
+  // in a single pass, and reports which of them decided the outcome
+  void ShouldStartRequest(const GURL& url,
+                          blink::mojom::ResourceType resource_type,
+                          const std::string& tab_host,
+                          bool* did_match_rule,
+                          bool* did_match_exception,
+                          bool* did_match_important,
+                          std::string* mock_data_url,
+                          AdBlockFilterListSource* matched_list);
   base::Optional<std::string> GetCspDirectives(
       const GURL& url,
       blink::mojom::ResourceType resource_type,
@@ -69,6 +90,7 @@ class AdBlockService : public AdBlockBaseService {
 
   AdBlockRegionalServiceManager* regional_service_manager();
   AdBlockCustomFiltersService* custom_filters_service();
+  AdBlockMatchCache* match_cache();
 
  protected:
   bool Init() override;
@@ -92,6 +114,7 @@ class AdBlockService : public AdBlockBaseService {
       regional_service_manager_;
   std::unique_ptr<brave_shields::AdBlockCustomFiltersService>
       custom_filters_service_;
+  AdBlockMatchCache match_cache_;
 
   BraveComponent::Delegate* component_delegate_;
 
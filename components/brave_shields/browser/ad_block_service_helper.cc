@@ -12,11 +12,29 @@
 #include "base/logging.h"
 #include "base/strings/string_util.h"
 #include "base/values.h"
+#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
 
 using adblock::FilterList;
 
 namespace brave_shields {
 
+void AdBlockServiceDomainResolver(const char* host,
+                                  uint32_t* start,
+                                  uint32_t* end) {
+  const auto host_str = std::string(host);
+  const auto domain = net::registry_controlled_domains::GetDomainAndRegistry(
+      host_str,
+      net::registry_controlled_domains::INCLUDE_PRIVATE_REGISTRIES);
+  const size_t match = host_str.rfind(domain);
+  if (match != std::string::npos) {
+    *start = match;
+    *end = match + domain.length();
+  } else {
+    *start = 0;
+    *end = host_str.length();
+  }
+}
+
 std::vector<FilterList>::const_iterator FindAdBlockFilterListByUUID(
     const std::vector<FilterList>& region_lists,
     const std::string& uuid) {
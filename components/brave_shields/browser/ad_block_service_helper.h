@@ -15,6 +15,12 @@
 
 namespace brave_shields {
 
+// Extracts the start and end characters of a domain from a hostname.
+// Required for correct functionality of adblock-rust.
+void AdBlockServiceDomainResolver(const char* host,
+                                  uint32_t* start,
+                                  uint32_t* end);
+
 std::vector<adblock::FilterList>::const_iterator FindAdBlockFilterListByUUID(
     const std::vector<adblock::FilterList>& region_lists,
     const std::string& uuid);
@@ -0,0 +1,142 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/https_everywhere_rules.h"
+
+#include <utility>
+
+#include "base/json/json_reader.h"
+#include "base/memory/ptr_util.h"
+#include "base/optional.h"
+#include "base/values.h"
+#include "third_party/re2/src/re2/re2.h"
+
+namespace brave_shields {
+
+namespace {
+
+// Returns null for patterns RE2 can't compile, which never match
+std::unique_ptr<re2::RE2> CompilePattern(const std::string& pattern) {
+  auto regex = std::make_unique<re2::RE2>(pattern, re2::RE2::Quiet);
+  if (!regex->ok()) {
+    return nullptr;
+  }
+  return regex;
+}
+
+}  // namespace
+
+HTTPSERules::Rule::Rule() = default;
+HTTPSERules::Rule::Rule(Rule&& other) = default;
+HTTPSERules::Rule::~Rule() = default;
+
+HTTPSERules::RuleSet::RuleSet() = default;
+HTTPSERules::RuleSet::RuleSet(RuleSet&& other) = default;
+HTTPSERules::RuleSet::~RuleSet() = default;
+
+HTTPSERules::HTTPSERules() = default;
+
+HTTPSERules::~HTTPSERules() = default;
+
+// static
+std::unique_ptr<HTTPSERules> HTTPSERules::Parse(const std::string& json) {
+  auto rules = base::WrapUnique(new HTTPSERules());
+
+  base::Optional<base::Value> json_object = base::JSONReader::Read(json);
+  if (!json_object || !json_object->is_list()) {
+    return rules;
+  }
+
+  for (const base::Value& rule_set_value : json_object->GetList()) {
+    if (!rule_set_value.is_dict()) {
+      continue;
+    }
+    RuleSet rule_set;
+
+    const base::Value* exclusions = rule_set_value.FindListKey("e");
+    if (exclusions) {
+      for (const base::Value& exclusion : exclusions->GetList()) {
+        if (!exclusion.is_dict()) {
+          continue;
+        }
+        const std::string* pattern = exclusion.FindStringKey("p");
+        if (!pattern) {
+          continue;
+        }
+        auto regex = CompilePattern(CorrectToRuleForRE2(*pattern));
+        if (regex) {
+          rule_set.exclusions.push_back(std::move(regex));
+        }
+      }
+    }
+
+    const base::Value* rule_values = rule_set_value.FindListKey("r");
+    if (rule_values) {
+      rule_set.has_rules = true;
+      for (const base::Value& rule_value : rule_values->GetList()) {
+        if (!rule_value.is_dict()) {
+          continue;
+        }
+        Rule rule;
+        if (!rule_value.FindKey("d")) {
+          const std::string* from = rule_value.FindStringKey("f");
+          const std::string* to = rule_value.FindStringKey("t");
+          if (!from || !to) {
+            continue;
+          }
+          rule.from = CompilePattern(*from);
+          if (!rule.from) {
+            continue;
+          }
+          rule.to = CorrectToRuleForRE2(*to);
+        }
+        rule_set.rules.push_back(std::move(rule));
+      }
+    }
+
+    rules->rule_sets_.push_back(std::move(rule_set));
+  }
+
+  return rules;
+}
+
+std::string HTTPSERules::Apply(const std::string& url) const {
+  for (const RuleSet& rule_set : rule_sets_) {
+    for (const auto& exclusion : rule_set.exclusions) {
+      if (re2::RE2::FullMatch(url, *exclusion)) {
+        return "";
+      }
+    }
+
+    if (!rule_set.has_rules) {
+      return "";
+    }
+
+    for (const Rule& rule : rule_set.rules) {
+      std::string new_url(url);
+      if (!rule.from) {
+        return new_url.insert(4, "s");
+      }
+      if (re2::RE2::Replace(&new_url, *rule.from, rule.to) &&
+          new_url != url) {
+        return new_url;
+      }
+    }
+  }
+  return "";
+}
+
+// static
+std::string HTTPSERules::CorrectToRuleForRE2(const std::string& to) {
+  std::string corrected_to(to);
+  size_t pos = corrected_to.find("$");
+  while (std::string::npos != pos) {
+    corrected_to[pos] = '\\';
+    pos = corrected_to.find("$", pos + 1);
+  }
+  return corrected_to;
+}
+
+}  // namespace brave_shields
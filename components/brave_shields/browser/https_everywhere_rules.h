@@ -0,0 +1,71 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_RULES_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_RULES_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+
+namespace re2 {
+class RE2;
+}
+
+namespace brave_shields {
+
+// The rulesets stored under one key of the HTTPS Everywhere database, parsed
+// once with their regexes compiled, so that they can be applied to many URLs.
+// Apply() is const and RE2 matching is thread-safe, so one instance can be
+// shared between sequences.
+class HTTPSERules {
+ public:
+  // |json| is the database value, a list of rulesets. Invalid values produce
+  // rules which never rewrite a URL.
+  static std::unique_ptr<HTTPSERules> Parse(const std::string& json);
+
+  ~HTTPSERules();
+
+  // Returns the HTTPS URL for |url|, or an empty string if the rules don't
+  // rewrite it.
+  std::string Apply(const std::string& url) const;
+
+  // Replaces the `$n` backreferences of a ruleset with RE2's `\n`
+  static std::string CorrectToRuleForRE2(const std::string& to);
+
+ private:
+  struct Rule {
+    Rule();
+    Rule(Rule&& other);
+    ~Rule();
+
+    // Null for rules which only change the scheme
+    std::unique_ptr<re2::RE2> from;
+    std::string to;
+  };
+
+  struct RuleSet {
+    RuleSet();
+    RuleSet(RuleSet&& other);
+    ~RuleSet();
+
+    std::vector<std::unique_ptr<re2::RE2>> exclusions;
+    // Rulesets without a rule list stop the lookup
+    bool has_rules = false;
+    std::vector<Rule> rules;
+  };
+
+  HTTPSERules();
+
+  std::vector<RuleSet> rule_sets_;
+
+  DISALLOW_COPY_AND_ASSIGN(HTTPSERules);
+};
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_RULES_H_
@@ -0,0 +1,95 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "brave/components/brave_shields/browser/https_everywhere_rules.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+// npm run test -- brave_unit_tests --filter=HTTPSERulesPerfTest.*
+// --gtest_also_run_disabled_tests
+
+namespace brave_shields {
+
+namespace {
+
+const char kMetricParsedPerUrl[] = ".parsed_per_url";
+const char kMetricCompiledOnce[] = ".compiled_once";
+
+const int kHostCount = 200;
+const int kUrlsPerHost = 50;
+
+// A ruleset shaped like the ones in the HTTPS Everywhere database, with an
+// exclusion and a few host rewrites
+std::string BuildRuleSet(int host) {
+  return base::StringPrintf(
+      R"([{"e": [{"p": "^http://(www\\.)?site%d\\.com/insecure/.*"}],)"
+      R"(   "r": [{"f": "^http://cdn\\.site%d\\.com/",)"
+      R"(          "t": "https://cdn-secure.site%d.com/"},)"
+      R"(         {"f": "^http://(www\\.)?site%d\\.com/",)"
+      R"(          "t": "https://$1site%d.com/"}]}])",
+      host, host, host, host, host);
+}
+
+}  // namespace
+
+class HTTPSERulesPerfTest : public testing::Test {
+ protected:
+  HTTPSERulesPerfTest() {
+    for (int host = 0; host < kHostCount; host++) {
+      rule_sets_.push_back(BuildRuleSet(host));
+      for (int i = 0; i < kUrlsPerHost; i++) {
+        urls_.push_back(base::StringPrintf(
+            "http://www.site%d.com/path/%d/page.html?q=%d", host, i, i));
+      }
+    }
+  }
+
+  // Parses the database value and builds the regexes for every URL, which is
+  // what every cache miss used to do
+  base::TimeDelta ApplyParsedPerUrl() {
+    const base::TimeTicks start = base::TimeTicks::Now();
+    for (size_t i = 0; i < urls_.size(); i++) {
+      const std::string new_url =
+          HTTPSERules::Parse(rule_sets_[i / kUrlsPerHost])->Apply(urls_[i]);
+      EXPECT_FALSE(new_url.empty());
+    }
+    return base::TimeTicks::Now() - start;
+  }
+
+  // Compiles each host's rules once, as the per-host cache does
+  base::TimeDelta ApplyCompiledOnce() {
+    const base::TimeTicks start = base::TimeTicks::Now();
+    std::vector<std::unique_ptr<HTTPSERules>> compiled;
+    for (const auto& rule_set : rule_sets_) {
+      compiled.push_back(HTTPSERules::Parse(rule_set));
+    }
+    for (size_t i = 0; i < urls_.size(); i++) {
+      const std::string new_url = compiled[i / kUrlsPerHost]->Apply(urls_[i]);
+      EXPECT_FALSE(new_url.empty());
+    }
+    return base::TimeTicks::Now() - start;
+  }
+
+  std::vector<std::string> rule_sets_;
+  std::vector<std::string> urls_;
+};
+
+TEST_F(HTTPSERulesPerfTest, DISABLED_UrlCorpus) {
+  perf_test::PerfResultReporter reporter(
+      "HTTPSERules.",
+      base::StringPrintf("%d_hosts_%d_urls", kHostCount, kUrlsPerHost));
+  reporter.RegisterImportantMetric(kMetricParsedPerUrl, "ms");
+  reporter.RegisterImportantMetric(kMetricCompiledOnce, "ms");
+  reporter.AddResult(kMetricParsedPerUrl, ApplyParsedPerUrl());
+  reporter.AddResult(kMetricCompiledOnce, ApplyCompiledOnce());
+}
+
+}  // namespace brave_shields
@@ -0,0 +1,76 @@
+/* Copyright (c) 2021 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/https_everywhere_rules.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+// npm run test -- brave_unit_tests --filter=HTTPSERulesTest.*
+
+namespace brave_shields {
+
+TEST(HTTPSERulesTest, RewritesMatchingUrl) {
+  auto rules = HTTPSERules::Parse(
+      R"([{"r": [{"f": "^http://(www\\.)?example\\.com/",)"
+      R"(         "t": "https://$1example.com/"}]}])");
+
+  EXPECT_EQ("https://www.example.com/page",
+            rules->Apply("http://www.example.com/page"));
+  EXPECT_EQ("https://example.com/", rules->Apply("http://example.com/"));
+  EXPECT_EQ("", rules->Apply("http://example.org/"));
+  // Rules are reused for every URL
+  EXPECT_EQ("https://example.com/other",
+            rules->Apply("http://example.com/other"));
+}
+
+TEST(HTTPSERulesTest, DefaultRuleOnlyChangesScheme) {
+  auto rules = HTTPSERules::Parse(R"([{"r": [{"d": 1}]}])");
+
+  EXPECT_EQ("https://example.com/page?q=1",
+            rules->Apply("http://example.com/page?q=1"));
+}
+
+TEST(HTTPSERulesTest, ExclusionStopsLookup) {
+  auto rules = HTTPSERules::Parse(
+      R"([{"e": [{"p": "^http://example\\.com/insecure/.*"}],)"
+      R"(   "r": [{"d": 1}]},)"
+      R"(  {"r": [{"d": 1}]}])");
+
+  EXPECT_EQ("", rules->Apply("http://example.com/insecure/page"));
+  EXPECT_EQ("https://example.com/page",
+            rules->Apply("http://example.com/page"));
+}
+
+TEST(HTTPSERulesTest, RuleSetWithoutRulesStopsLookup) {
+  auto rules = HTTPSERules::Parse(R"([{"e": []}, {"r": [{"d": 1}]}])");
+
+  EXPECT_EQ("", rules->Apply("http://example.com/"));
+}
+
+TEST(HTTPSERulesTest, LaterRuleSetsAreTried) {
+  auto rules = HTTPSERules::Parse(
+      R"([{"r": [{"f": "^http://a\\.example\\.com/",)"
+      R"(          "t": "https://a.example.com/"}]},)"
+      R"(  {"r": [{"f": "^http://b\\.example\\.com/",)"
+      R"(          "t": "https://b.example.com/"}]}])");
+
+  EXPECT_EQ("https://b.example.com/", rules->Apply("http://b.example.com/"));
+}
+
+TEST(HTTPSERulesTest, InvalidRulesNeverRewrite) {
+  EXPECT_EQ("", HTTPSERules::Parse("")->Apply("http://example.com/"));
+  EXPECT_EQ("", HTTPSERules::Parse("{}")->Apply("http://example.com/"));
+  EXPECT_EQ("", HTTPSERules::Parse(R"([{"r": [{"f": "(", "t": "https://"}]}])")
+                    ->Apply("http://example.com/"));
+}
+
+TEST(HTTPSERulesTest, CorrectToRuleForRE2) {
+  EXPECT_EQ("https://\\1example.com/\\2",
+            HTTPSERules::CorrectToRuleForRE2("https://$1example.com/$2"));
+  EXPECT_EQ("https://example.com/",
+            HTTPSERules::CorrectToRuleForRE2("https://example.com/"));
+}
+
+}  // namespace brave_shields
@@ -12,21 +12,19 @@
 
 #include "base/base_paths.h"
 #include "base/bind.h"
-#include "base/json/json_reader.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/threading/scoped_blocking_call.h"
-#include "base/values.h"
 #include "third_party/leveldatabase/src/include/leveldb/db.h"
-#include "third_party/re2/src/re2/re2.h"
 #include "third_party/zlib/google/zip.h"
 
 #define DAT_FILE "httpse.leveldb.zip"
 #define DAT_FILE_VERSION "6.0"
 #define HTTPSE_URLS_REDIRECTS_COUNT_QUEUE   1
 #define HTTPSE_URL_MAX_REDIRECTS_COUNT      5
+#define HTTPSE_HOST_RULES_CACHE_SIZE        1000
 
 namespace {
 
@@ -100,6 +98,8 @@ HTTPSEverywhereService::g_https_everywhere_component_base64_public_key_(
 HTTPSEverywhereService::HTTPSEverywhereService(
     BraveComponent::Delegate* delegate)
     : BaseBraveShieldsService(delegate),
+      httpse_urls_redirects_count_(HTTPSE_URLS_REDIRECTS_COUNT_QUEUE),
+      host_rules_cache_(HTTPSE_HOST_RULES_CACHE_SIZE),
       level_db_(nullptr) {
   DETACH_FROM_SEQUENCE(sequence_checker_);
 }
@@ -128,6 +128,8 @@ void HTTPSEverywhereService::InitDB(const base::FilePath& install_dir) {
   }
 
   CloseDatabase();
+  // Rules compiled from the previous database may have changed
+  host_rules_cache_.Clear();
 
   leveldb::Options options;
   leveldb::Status status =
@@ -182,23 +184,37 @@ bool HTTPSEverywhereService::GetHTTPSURL(
     candidate_url = candidate_url.ReplaceComponents(replacements);
   }
 
-  const std::vector<std::string> domains =
-      ExpandDomainForLookup(candidate_url.host());
-  for (auto domain : domains) {
-    std::string value = leveldbGet(level_db_, domain);
-    if (!value.empty()) {
-      *new_url = ApplyHTTPSRule(candidate_url.spec(), value);
-      if (0 != new_url->length()) {
-        recently_used_cache_.add(candidate_url.spec(), *new_url);
-        AddHTTPSEUrlToRedirectList(request_identifier);
-        return true;
-      }
+  for (const auto& rules : GetRulesForHost(candidate_url.host())) {
+    *new_url = rules->Apply(candidate_url.spec());
+    if (0 != new_url->length()) {
+      recently_used_cache_.add(candidate_url.spec(), *new_url);
+      AddHTTPSEUrlToRedirectList(request_identifier);
+      return true;
     }
   }
   recently_used_cache_.remove(candidate_url.spec());
   return false;
 }
 
+const HTTPSEHostRules& HTTPSEverywhereService::GetRulesForHost(
+    const std::string& host) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  auto it = host_rules_cache_.Get(host);
+  if (it != host_rules_cache_.end()) {
+    return it->second;
+  }
+
+  HTTPSEHostRules host_rules;
+  const std::vector<std::string> domains = ExpandDomainForLookup(host);
+  for (const auto& domain : domains) {
+    std::string value = leveldbGet(level_db_, domain);
+    if (!value.empty()) {
+      host_rules.push_back(HTTPSERules::Parse(value));
+    }
+  }
+  return host_rules_cache_.Put(host, std::move(host_rules))->second;
+}
+
 bool HTTPSEverywhereService::GetHTTPSURLFromCacheOnly(
     const GURL* url,
     const uint64_t& request_identifier,
@@ -223,155 +239,23 @@ bool HTTPSEverywhereService::GetHTTPSURLFromCacheOnly(
 bool HTTPSEverywhereService::ShouldHTTPSERedirect(
     const uint64_t& request_identifier) {
   base::AutoLock auto_lock(httpse_get_urls_redirects_count_mutex_);
-  for (size_t i = 0; i < httpse_urls_redirects_count_.size(); i++) {
-    if (request_identifier ==
-        httpse_urls_redirects_count_[i].request_identifier_ &&
-        httpse_urls_redirects_count_[i].redirects_ >=
-        HTTPSE_URL_MAX_REDIRECTS_COUNT - 1) {
-      return false;
-    }
-  }
-
-  return true;
+  auto it = httpse_urls_redirects_count_.Peek(request_identifier);
+  return it == httpse_urls_redirects_count_.end() ||
+         it->second < HTTPSE_URL_MAX_REDIRECTS_COUNT - 1;
 }
 
 void HTTPSEverywhereService::AddHTTPSEUrlToRedirectList(
     const uint64_t& request_identifier) {
   // Adding redirects count for the current request
   base::AutoLock auto_lock(httpse_get_urls_redirects_count_mutex_);
-  bool hostFound = false;
-  for (size_t i = 0; i < httpse_urls_redirects_count_.size(); i++) {
-    if (request_identifier ==
-        httpse_urls_redirects_count_[i].request_identifier_) {
-      // Found the host, just increment the redirects_count
-      httpse_urls_redirects_count_[i].redirects_++;
-      hostFound = true;
-      break;
-    }
-  }
-  if (!hostFound) {
-      // The host is new, adding it to the redirects list
-      if (httpse_urls_redirects_count_.size() >=
-          HTTPSE_URLS_REDIRECTS_COUNT_QUEUE) {
-          // The queue is full, erase the first element
-          httpse_urls_redirects_count_.erase(
-              httpse_urls_redirects_count_.begin());
-      }
-      httpse_urls_redirects_count_.push_back(
-          HTTPSE_REDIRECTS_COUNT_ST(request_identifier, 1));
-  }
-}
-
-std::string HTTPSEverywhereService::ApplyHTTPSRule(
-    const std::string& originalUrl,
-    const std::string& rule) {
-  base::Optional<base::Value> json_object = base::JSONReader::Read(rule);
-  if (base::nullopt == json_object || !json_object->is_list()) {
-    return "";
-  }
-
-  base::Value::ConstListView topValues = json_object->GetList();
-  for (auto it = topValues.cbegin(); it != topValues.cend(); ++it) {
-    if (!it->is_dict()) {
-      continue;
-    }
-    const base::DictionaryValue* childTopDictionary = nullptr;
-    it->GetAsDictionary(&childTopDictionary);
-    if (nullptr == childTopDictionary) {
-      continue;
-    }
-
-    const base::Value* exclusion = nullptr;
-    if (childTopDictionary->Get("e", &exclusion)) {
-      const base::ListValue* eValues = nullptr;
-      exclusion->GetAsList(&eValues);
-      if (nullptr != eValues) {
-        for (size_t j = 0; j < eValues->GetSize(); ++j) {
-          const base::Value* pValue = nullptr;
-          if (!eValues->Get(j, &pValue)) {
-            continue;
-          }
-          const base::DictionaryValue* pDictionary = nullptr;
-          pValue->GetAsDictionary(&pDictionary);
-          if (nullptr == pDictionary) {
-            continue;
-          }
-          const base::Value* patternValue = nullptr;
-          if (!pDictionary->Get("p", &patternValue)) {
-            continue;
-          }
-          std::string pattern;
-          if (!patternValue->GetAsString(&pattern)) {
-            continue;
-          }
-          pattern = CorrecttoRuleToRE2Engine(pattern);
-          if (RE2::FullMatch(originalUrl, pattern)) {
-            return "";
-          }
-        }
-      }
-    }
-
-    const base::Value* rules = nullptr;
-    if (!childTopDictionary->Get("r", &rules)) {
-      return "";
-    }
-    const base::ListValue* rValues = nullptr;
-    rules->GetAsList(&rValues);
-    if (nullptr == rValues) {
-      return "";
-    }
-
-    for (size_t j = 0; j < rValues->GetSize(); ++j) {
-      const base::Value* pValue = nullptr;
-      if (!rValues->Get(j, &pValue)) {
-        continue;
-      }
-      const base::DictionaryValue* pDictionary = nullptr;
-      pValue->GetAsDictionary(&pDictionary);
-      if (nullptr == pDictionary) {
-        continue;
-      }
-      const base::Value* patternValue = nullptr;
-      if (pDictionary->Get("d", &patternValue)) {
-        std::string newUrl(originalUrl);
-        return newUrl.insert(4, "s");
-      }
-
-      const base::Value* from_value = nullptr;
-      const base::Value* to_value = nullptr;
-      if (!pDictionary->Get("f", &from_value) ||
-          !pDictionary->Get("t", &to_value)) {
-        continue;
-      }
-      std::string from, to;
-      if (!from_value->GetAsString(&from) ||
-          !to_value->GetAsString(&to)) {
-        continue;
-      }
-
-      to = CorrecttoRuleToRE2Engine(to);
-      std::string newUrl(originalUrl);
-      RE2 regExp(from);
-
-      if (RE2::Replace(&newUrl, regExp, to) && newUrl != originalUrl) {
-        return newUrl;
-      }
-    }
+  // Peek rather than Get, so that the oldest request is dropped first when
+  // the list is full
+  auto it = httpse_urls_redirects_count_.Peek(request_identifier);
+  if (it != httpse_urls_redirects_count_.end()) {
+    it->second++;
+  } else {
+    httpse_urls_redirects_count_.Put(request_identifier, 1);
   }
-  return "";
-}
-
-std::string HTTPSEverywhereService::CorrecttoRuleToRE2Engine(
-    const std::string& to) {
-  std::string correctedto(to);
-  size_t pos = to.find("$");
-  while (std::string::npos != pos) {
-    correctedto[pos] = '\\';
-    pos = correctedto.find("$");
-  }
-
-  return correctedto;
 }
 
 void HTTPSEverywhereService::CloseDatabase() {
@@ -10,12 +10,14 @@
 #include <string>
 #include <vector>
 
+#include "base/containers/mru_cache.h"
 #include "base/files/file_path.h"
 #include "base/memory/weak_ptr.h"
 #include "base/sequence_checker.h"
 #include "base/synchronization/lock.h"
 #include "brave/components/brave_shields/browser/base_brave_shields_service.h"
 #include "brave/components/brave_shields/browser/https_everywhere_recently_used_cache.h"
+#include "brave/components/brave_shields/browser/https_everywhere_rules.h"
 
 namespace leveldb {
 class DB;
@@ -31,17 +33,8 @@ extern const char kHTTPSEverywhereComponentName[];
 extern const char kHTTPSEverywhereComponentId[];
 extern const char kHTTPSEverywhereComponentBase64PublicKey[];
 
-struct HTTPSE_REDIRECTS_COUNT_ST {
- public:
-  HTTPSE_REDIRECTS_COUNT_ST(uint64_t request_identifier,
-                            unsigned int redirects):
-    request_identifier_(request_identifier),
-    redirects_(redirects) {
-  }
-
-  uint64_t request_identifier_;
-  unsigned int redirects_;
-};
+// The rules of every database key a host is looked up under
+using HTTPSEHostRules = std::vector<std::unique_ptr<HTTPSERules>>;
 
 class HTTPSEverywhereService : public BaseBraveShieldsService,
                          public base::SupportsWeakPtr<HTTPSEverywhereService> {
@@ -63,9 +56,6 @@ class HTTPSEverywhereService : public BaseBraveShieldsService,
 
   void AddHTTPSEUrlToRedirectList(const uint64_t& request_id);
   bool ShouldHTTPSERedirect(const uint64_t& request_id);
-  std::string ApplyHTTPSRule(const std::string& originalUrl,
-      const std::string& rule);
-  std::string CorrecttoRuleToRE2Engine(const std::string& to);
 
  private:
   friend class ::HTTPSEverywhereServiceTest;
@@ -81,9 +71,17 @@ class HTTPSEverywhereService : public BaseBraveShieldsService,
 
   void InitDB(const base::FilePath& install_dir);
 
+  // Returns the rules for |host|, in lookup order, reading and compiling them
+  // on first use
+  const HTTPSEHostRules& GetRulesForHost(const std::string& host);
+
   base::Lock httpse_get_urls_redirects_count_mutex_;
-  std::vector<HTTPSE_REDIRECTS_COUNT_ST> httpse_urls_redirects_count_;
+  // Redirects made so far, keyed by request id
+  base::HashingMRUCache<uint64_t, unsigned int> httpse_urls_redirects_count_;
   HTTPSERecentlyUsedCache<std::string> recently_used_cache_;
+  // Compiled rules by host. Hosts without rules map to an empty list. Only
+  // used on the service's task runner.
+  base::MRUCache<std::string, HTTPSEHostRules> host_rules_cache_;
   leveldb::DB* level_db_;
 
   SEQUENCE_CHECKER(sequence_checker_);